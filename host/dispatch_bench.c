@@ -0,0 +1,241 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host microbenchmark of the WICED HCI command and model event dispatch of mesh_onoff_server.c. The application
+ * source is included in this file so that the benchmark can call the dispatch tables and the handlers directly.
+ * The same handlers are also called through a switch over the opcode or event, as the application dispatched
+ * them before the tables, and the benchmark reports nanoseconds per dispatch of both.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../mesh_onoff_server.c"
+
+#define DISPATCH_BENCH_DEFAULT_OPS      10000000
+#define DISPATCH_BENCH_OPCODE_UNKNOWN   ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x7f)
+#define DISPATCH_BENCH_EVENT_UNKNOWN    0xffff
+
+static volatile uintptr_t dispatch_bench_sink;
+
+static uint64_t dispatch_bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Handler of the WICED HCI command found with a switch
+ */
+static mesh_app_hci_cmd_handler_t dispatch_bench_switch_find_cmd(uint16_t opcode)
+{
+    switch (opcode)
+    {
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SET:
+        return mesh_onoff_hci_cmd_onoff_set;
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI:
+        return mesh_onoff_hci_cmd_onoff_set_multi;
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET:
+        return mesh_onoff_hci_cmd_report_policy_set;
+#ifdef ONOFF_STATS_SUPPORTED
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET:
+        return mesh_onoff_hci_cmd_stats_get;
+#endif
+#ifdef ONOFF_SCENES_SUPPORTED
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE:
+        return mesh_onoff_hci_cmd_scene_store;
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL:
+        return mesh_onoff_hci_cmd_scene_recall;
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE:
+        return mesh_onoff_hci_cmd_scene_delete;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+/*
+ * mesh_app_proc_rx_cmd with the switch instead of the dispatch table
+ */
+static uint32_t dispatch_bench_switch_rx_cmd(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    MESH_ONOFF_STATS_START(mesh_onoff_stats_cmd_start);
+    MESH_ONOFF_BOOT_TIME(MESH_ONOFF_BOOT_PHASE_FIRST_COMMAND);
+    MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_RX_CMD, opcode, 0, 0);
+
+    switch (opcode)
+    {
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SET:
+        return mesh_onoff_hci_cmd_onoff_set(p_data, length);
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI:
+        return mesh_onoff_hci_cmd_onoff_set_multi(p_data, length);
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET:
+        return mesh_onoff_hci_cmd_report_policy_set(p_data, length);
+#ifdef ONOFF_STATS_SUPPORTED
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET:
+        return mesh_onoff_hci_cmd_stats_get(p_data, length);
+#endif
+#ifdef ONOFF_SCENES_SUPPORTED
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE:
+        return mesh_onoff_hci_cmd_scene_store(p_data, length);
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL:
+        return mesh_onoff_hci_cmd_scene_recall(p_data, length);
+    case HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE:
+        return mesh_onoff_hci_cmd_scene_delete(p_data, length);
+#endif
+    default:
+        MESH_ONOFF_STATS_INC(cmd_unknown);
+        MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_UNKNOWN_CMD, opcode, 0, 0);
+        return WICED_FALSE;
+    }
+}
+
+/*
+ * mesh_onoff_server_message_handler with the switch instead of the dispatch table
+ */
+static void dispatch_bench_switch_message_handler(uint8_t element_idx, uint16_t event, void *p_data)
+{
+    switch (event)
+    {
+    case WICED_BT_MESH_ONOFF_STATUS:
+        mesh_onoff_server_status_event(element_idx, p_data);
+        break;
+    default:
+        MESH_ONOFF_STATS_INC(event_unknown);
+        MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_UNKNOWN_EVENT, event, 0, 0);
+    }
+}
+
+static void dispatch_bench_report(const char *p_name, uint32_t num_ops, uint64_t table_ns, uint64_t switch_ns)
+{
+    printf("%-20s ops:%u table:%.1fns switch:%.1fns\n", p_name, num_ops, (double)table_ns / num_ops, (double)switch_ns / num_ops);
+}
+
+/*
+ * Look up the handler of each registered command and of an unknown command in turn
+ */
+static void dispatch_bench_find_cmd(uint32_t num_ops)
+{
+    uint16_t opcodes[MESH_APP_HCI_CMD_HANDLERS_MAX + 1];
+    uint32_t num_opcodes, i;
+    uint64_t start_ns, table_ns, switch_ns;
+
+    for (num_opcodes = 0; num_opcodes < mesh_app_hci_cmd_table.num_entries; num_opcodes++)
+        opcodes[num_opcodes] = (uint16_t)mesh_app_hci_cmd_table.p_entries[num_opcodes].key;
+    opcodes[num_opcodes++] = DISPATCH_BENCH_OPCODE_UNKNOWN;
+
+    start_ns = dispatch_bench_now_ns();
+    for (i = 0; i < num_ops; i++)
+        dispatch_bench_sink = (uintptr_t)mesh_app_dispatch_find(&mesh_app_hci_cmd_table, opcodes[i % num_opcodes]);
+    table_ns = dispatch_bench_now_ns() - start_ns;
+
+    start_ns = dispatch_bench_now_ns();
+    for (i = 0; i < num_ops; i++)
+        dispatch_bench_sink = (uintptr_t)dispatch_bench_switch_find_cmd(opcodes[i % num_opcodes]);
+    switch_ns = dispatch_bench_now_ns() - start_ns;
+
+    dispatch_bench_report("find_cmd", num_ops, table_ns, switch_ns);
+}
+
+/*
+ * Report Policy Set commands, the cheapest handler, and unknown commands in turn
+ */
+static void dispatch_bench_rx_cmd(uint32_t num_ops)
+{
+    uint8_t  cmd[HOST_HCI_HEADER_LEN + 2] = { 0 };
+    uint16_t opcodes[2] = { HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET, DISPATCH_BENCH_OPCODE_UNKNOWN };
+    uint32_t i;
+    uint64_t start_ns, table_ns, switch_ns;
+
+    cmd[HOST_HCI_HEADER_LEN]     = MESH_ONOFF_REPORT_POLICY_DEFAULT;
+    cmd[HOST_HCI_HEADER_LEN + 1] = NUM_ONOFF_SERVERS;
+
+    start_ns = dispatch_bench_now_ns();
+    for (i = 0; i < num_ops; i++)
+        dispatch_bench_sink = mesh_app_proc_rx_cmd(opcodes[i & 1], cmd, sizeof(cmd));
+    table_ns = dispatch_bench_now_ns() - start_ns;
+
+    start_ns = dispatch_bench_now_ns();
+    for (i = 0; i < num_ops; i++)
+        dispatch_bench_sink = dispatch_bench_switch_rx_cmd(opcodes[i & 1], cmd, sizeof(cmd));
+    switch_ns = dispatch_bench_now_ns() - start_ns;
+
+    dispatch_bench_report("proc_rx_cmd", num_ops, table_ns, switch_ns);
+}
+
+/*
+ * OnOff Status events which do not change the state of the element and unknown events in turn
+ */
+static void dispatch_bench_message_handler(uint32_t num_ops)
+{
+    wiced_bt_mesh_onoff_status_data_t status = { 0 };
+    uint16_t events[2] = { WICED_BT_MESH_ONOFF_STATUS, DISPATCH_BENCH_EVENT_UNKNOWN };
+    uint32_t i;
+    uint64_t start_ns, table_ns, switch_ns;
+
+    start_ns = dispatch_bench_now_ns();
+    for (i = 0; i < num_ops; i++)
+        mesh_onoff_server_message_handler(0, events[i & 1], &status);
+    table_ns = dispatch_bench_now_ns() - start_ns;
+
+    start_ns = dispatch_bench_now_ns();
+    for (i = 0; i < num_ops; i++)
+        dispatch_bench_switch_message_handler(0, events[i & 1], &status);
+    switch_ns = dispatch_bench_now_ns() - start_ns;
+
+    dispatch_bench_report("message_handler", num_ops, table_ns, switch_ns);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num_ops = DISPATCH_BENCH_DEFAULT_OPS;
+
+    if (argc > 1)
+        num_ops = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (num_ops == 0)
+    {
+        fprintf(stderr, "usage: %s [number of operations]\n", argv[0]);
+        return 1;
+    }
+
+    wiced_bt_mesh_app_func_table.p_mesh_app_init(WICED_TRUE);
+
+    printf("elements:%d commands:%d events:%d\n", NUM_ONOFF_SERVERS, mesh_app_hci_cmd_table.num_entries, mesh_app_model_event_table.num_entries);
+    dispatch_bench_find_cmd(num_ops);
+    dispatch_bench_rx_cmd(num_ops);
+    dispatch_bench_message_handler(num_ops);
+    return 0;
+}
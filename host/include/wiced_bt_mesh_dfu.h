@@ -0,0 +1 @@
+#include "wiced_host.h"
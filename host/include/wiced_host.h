@@ -0,0 +1,328 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host stand-ins for the part of the AIROC BTSDK API used by mesh_onoff_server.c.
+ * Declarations follow the SDK headers closely enough for the application to compile unmodified.
+ * Each SDK header of the application is a one line file in this folder including this file.
+ */
+#ifndef WICED_HOST_H
+#define WICED_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/******************************************************
+ *          wiced_result.h, wiced_bt_types.h
+ ******************************************************/
+typedef uint8_t wiced_bool_t;
+typedef uint32_t wiced_result_t;
+
+#define WICED_TRUE                                          1
+#define WICED_FALSE                                         0
+#define WICED_SUCCESS                                       0
+#define WICED_ERROR                                         1
+
+#define UINT8_TO_STREAM(p, u8)      {*(p)++ = (uint8_t)(u8);}
+#define UINT16_TO_STREAM(p, u16)    {*(p)++ = (uint8_t)(u16); *(p)++ = (uint8_t)((u16) >> 8);}
+#define UINT32_TO_STREAM(p, u32)    {*(p)++ = (uint8_t)(u32); *(p)++ = (uint8_t)((u32) >> 8); *(p)++ = (uint8_t)((u32) >> 16); *(p)++ = (uint8_t)((u32) >> 24);}
+#define STREAM_TO_UINT8(u8, p)      {u8 = (uint8_t)(*(p)); (p) += 1;}
+#define STREAM_TO_UINT16(u16, p)    {u16 = ((uint16_t)(*(p)) + (((uint16_t)(*((p) + 1))) << 8)); (p) += 2;}
+#define STREAM_TO_UINT32(u32, p)    {u32 = (((uint32_t)(*(p))) + ((((uint32_t)(*((p) + 1)))) << 8) + ((((uint32_t)(*((p) + 2)))) << 16) + ((((uint32_t)(*((p) + 3)))) << 24)); (p) += 4;}
+
+/******************************************************
+ *          wiced_bt_trace.h
+ ******************************************************/
+extern int host_trace_enabled;
+void host_trace(const char *p_fmt, ...);
+#define WICED_BT_TRACE(...)         do { if (host_trace_enabled) host_trace(__VA_ARGS__); } while (0)
+
+/******************************************************
+ *          wiced_bt_ble.h, wiced_bt_cfg.h
+ ******************************************************/
+#define BTM_BLE_ADVERT_TYPE_NAME_COMPLETE                   0x09
+#define BTM_BLE_ADVERT_TYPE_APPEARANCE                      0x19
+#define APPEARANCE_GENERIC_TAG                              0x0200
+
+typedef struct
+{
+    uint8_t     advert_type;
+    uint16_t    len;
+    uint8_t     *p_data;
+} wiced_bt_ble_advert_elem_t;
+
+typedef struct
+{
+    uint16_t    appearance;
+} wiced_bt_cfg_gatt_t;
+
+typedef struct
+{
+    uint8_t             *device_name;
+    wiced_bt_cfg_gatt_t gatt_cfg;
+} wiced_bt_cfg_settings_t;
+
+/******************************************************
+ *          wiced_timer.h
+ ******************************************************/
+#define TIMER_PARAM_TYPE                                    uint32_t
+
+#define WICED_SECONDS_TIMER                                 1
+#define WICED_MILLI_SECONDS_TIMER                           2
+#define WICED_SECONDS_PERIODIC_TIMER                        3
+#define WICED_MILLI_SECONDS_PERIODIC_TIMER                  4
+
+typedef void (wiced_timer_callback_t)(TIMER_PARAM_TYPE arg);
+
+typedef struct wiced_timer_s
+{
+    wiced_timer_callback_t  *p_cback;
+    TIMER_PARAM_TYPE        cback_param;
+    uint8_t                 type;
+    uint8_t                 in_use;
+    uint32_t                timeout_ms;
+    uint64_t                expire_ms;
+    struct wiced_timer_s    *p_next;
+} wiced_timer_t;
+
+wiced_result_t wiced_init_timer(wiced_timer_t *p_timer, wiced_timer_callback_t *p_cb, TIMER_PARAM_TYPE cb_param, uint8_t timer_type);
+wiced_result_t wiced_start_timer(wiced_timer_t *p_timer, uint32_t timeout);
+wiced_result_t wiced_stop_timer(wiced_timer_t *p_timer);
+wiced_bool_t wiced_is_timer_in_use(wiced_timer_t *p_timer);
+uint64_t clock_SystemTimeMicroseconds64(void);
+
+/******************************************************
+ *          wiced_hal_nvram.h
+ ******************************************************/
+#define WICED_NVRAM_VSID_START                              0x200
+#define WICED_NVRAM_VSID_END                                0x3FFF
+
+uint16_t wiced_hal_write_nvram(uint16_t vs_id, uint16_t data_length, uint8_t *p_data, wiced_result_t *p_status);
+uint16_t wiced_hal_read_nvram(uint16_t vs_id, uint16_t data_length, uint8_t *p_data, wiced_result_t *p_status);
+void wiced_hal_delete_nvram(uint16_t vs_id, wiced_result_t *p_status);
+
+/******************************************************
+ *          wiced_bt_mesh_models.h, wiced_bt_mesh_core.h
+ ******************************************************/
+#define MESH_COMPANY_ID_BT_SIG                              0x0000
+#define MESH_COMPANY_ID_CYPRESS                             0x0131
+#define MESH_ELEM_LOC_MAIN                                  0x0000
+#define MESH_DEFAULT_TRANSITION_TIME_IN_MS                  0
+
+#define WICED_BT_MESH_CORE_FEATURE_BIT_RELAY                0x0001
+#define WICED_BT_MESH_CORE_FEATURE_BIT_GATT_PROXY_SERVER    0x0002
+#define WICED_BT_MESH_CORE_FEATURE_BIT_FRIEND               0x0004
+#define WICED_BT_MESH_CORE_FEATURE_BIT_LOW_POWER            0x0008
+
+#define WICED_BT_MESH_ON_POWER_UP_STATE_OFF                 0
+#define WICED_BT_MESH_ON_POWER_UP_STATE_DEFAULT             1
+#define WICED_BT_MESH_ON_POWER_UP_STATE_RESTORE             2
+
+#define WICED_BT_MESH_PROPERTY_LEN_DEVICE_MANUFACTURER_NAME 32
+#define WICED_BT_MESH_PROPERTY_LEN_DEVICE_MODEL_NUMBER      24
+
+#define WICED_BT_MESH_CORE_MODEL_ID_GENERIC_ONOFF_SRV       0x1000
+
+#define WICED_BT_MESH_ONOFF_STATUS                          1
+#define WICED_BT_MESH_ONOFF_SET                             2
+
+typedef struct
+{
+    uint16_t    company_id;
+    uint16_t    model_id;
+    uint16_t    opcode;
+    uint16_t    src;
+    uint16_t    dst;
+    uint16_t    app_key_idx;
+    uint8_t     element_idx;
+    uint8_t     reply;
+} wiced_bt_mesh_event_t;
+
+typedef wiced_bool_t (*wiced_bt_mesh_core_received_msg_handler_t)(wiced_bt_mesh_event_t *p_event, uint8_t *p_data, uint16_t data_len);
+typedef void (*wiced_bt_mesh_core_send_complete_callback_t)(wiced_bt_mesh_event_t *p_event);
+
+typedef struct
+{
+    uint16_t                                    company_id;
+    uint16_t                                    model_id;
+    wiced_bt_mesh_core_received_msg_handler_t   p_message_handler;
+    void                                        *p_scene_store_handler;
+    void                                        *p_scene_recall_handler;
+} wiced_bt_mesh_core_config_model_t;
+
+typedef struct
+{
+    uint16_t                            location;
+    uint32_t                            default_transition_time;
+    uint8_t                             onpowerup_state;
+    uint16_t                            default_level;
+    uint16_t                            range_min;
+    uint16_t                            range_max;
+    uint8_t                             move_rollover;
+    uint8_t                             properties_num;
+    void                                *properties;
+    uint8_t                             sensors_num;
+    void                                *sensors;
+    uint8_t                             models_num;
+    wiced_bt_mesh_core_config_model_t   *models;
+} wiced_bt_mesh_core_config_element_t;
+
+typedef struct
+{
+    uint32_t    receive_window;
+    uint16_t    cache_buf_len;
+    uint8_t     max_lpn_num;
+} wiced_bt_mesh_core_config_friend_t;
+
+typedef struct
+{
+    uint8_t     rssi_factor;
+    uint8_t     receive_window_factor;
+    uint8_t     min_cache_size_log;
+    uint8_t     receive_delay;
+    uint32_t    poll_timeout;
+} wiced_bt_mesh_core_config_low_power_t;
+
+typedef struct
+{
+    uint16_t                                company_id;
+    uint16_t                                product_id;
+    uint16_t                                vendor_id;
+    uint16_t                                features;
+    wiced_bt_mesh_core_config_friend_t      friend_cfg;
+    wiced_bt_mesh_core_config_low_power_t   low_power;
+    wiced_bool_t                            gatt_client_only;
+    uint8_t                                 elements_num;
+    wiced_bt_mesh_core_config_element_t     *elements;
+} wiced_bt_mesh_core_config_t;
+
+typedef struct
+{
+    uint8_t     present_onoff;
+    uint8_t     target_onoff;
+    uint32_t    remaining_time;
+} wiced_bt_mesh_onoff_status_data_t;
+
+typedef void (wiced_bt_mesh_onoff_server_callback_t)(uint8_t element_idx, uint16_t event, void *p_data);
+
+#define WICED_BT_MESH_MODEL_STUB(id)                        { MESH_COMPANY_ID_BT_SIG, id, NULL, NULL, NULL }
+#define WICED_BT_MESH_DEVICE                                WICED_BT_MESH_MODEL_STUB(0x0000)
+#define WICED_BT_MESH_MODEL_ONOFF_SERVER                    WICED_BT_MESH_MODEL_STUB(WICED_BT_MESH_CORE_MODEL_ID_GENERIC_ONOFF_SRV)
+#define WICED_BT_MESH_MODEL_LARGE_COMPOS_DATA_SERVER        WICED_BT_MESH_MODEL_STUB(0xbf2c)
+#define WICED_BT_MESH_MODEL_PRIVATE_PROXY_SERVER            WICED_BT_MESH_MODEL_STUB(0x0008)
+#define WICED_BT_MESH_DIRECTED_FORWARDING_SERVER            WICED_BT_MESH_MODEL_STUB(0xbf30)
+#define WICED_BT_MESH_NETWORK_FILTER_SERVER                 WICED_BT_MESH_MODEL_STUB(0xbf40)
+#define WICED_BT_MESH_MODEL_REMOTE_PROVISION_SERVER         WICED_BT_MESH_MODEL_STUB(0x0004)
+#define WICED_BT_MESH_MODEL_OPCODES_AGGREGATOR_SERVER       WICED_BT_MESH_MODEL_STUB(0x0012)
+#define WICED_BT_MESH_MODEL_FW_DISTRIBUTOR_UPDATE_SERVER    WICED_BT_MESH_MODEL_STUB(0x1402)
+#define WICED_BT_MESH_MODEL_LIGHT_HSL_CTL_XYL_SERVER        WICED_BT_MESH_MODEL_STUB(0x130c)
+
+void wiced_bt_mesh_model_onoff_server_init(uint8_t element_idx, wiced_bt_mesh_onoff_server_callback_t *p_callback, uint32_t report_interval, wiced_bool_t is_provisioned);
+void wiced_bt_mesh_model_onoff_changed(uint8_t element_idx, uint8_t onoff);
+wiced_bt_mesh_event_t *wiced_bt_mesh_create_event(uint8_t element_idx, uint16_t company_id, uint16_t model_id, uint16_t dst, uint16_t app_key_idx);
+void wiced_bt_mesh_release_event(wiced_bt_mesh_event_t *p_event);
+wiced_result_t wiced_bt_mesh_core_send(wiced_bt_mesh_event_t *p_event, const uint8_t *params, uint16_t params_len, wiced_bt_mesh_core_send_complete_callback_t complete_callback);
+void wiced_bt_mesh_remote_provisioning_server_init(void);
+void wiced_bt_mesh_model_fw_distribution_server_init(void);
+void wiced_bt_mesh_directed_forwarding_init(wiced_bool_t directed_proxy_supported, wiced_bool_t directed_friend_supported, int8_t default_rssi_threshold,
+    uint8_t max_dt_entries_cnt, uint8_t node_paths, uint8_t relay_paths, uint8_t proxy_paths, uint8_t friend_paths);
+void wiced_bt_mesh_network_filter_init(void);
+
+/******************************************************
+ *          wiced_bt_mesh_app.h, hci_control_api.h
+ ******************************************************/
+#define HCI_CONTROL_GROUP_MESH                              0x16
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_SET                  ((HCI_CONTROL_GROUP_MESH << 8) | 0x10)
+#define HCI_CONTROL_MESH_EVENT_ONOFF_STATUS                 ((HCI_CONTROL_GROUP_MESH << 8) | 0x11)
+
+typedef struct
+{
+    uint16_t    dst;
+    uint16_t    app_key_idx;
+    uint8_t     element_idx;
+    uint8_t     data[1];
+} wiced_bt_mesh_hci_event_t;
+
+typedef void (*wiced_bt_mesh_app_init_t)(wiced_bool_t is_provisioned);
+typedef void (*wiced_bt_mesh_app_hardware_init_t)(void);
+typedef void (*wiced_bt_mesh_app_gatt_conn_status_t)(void *p_status);
+typedef void (*wiced_bt_mesh_app_attention_t)(uint8_t element_idx, uint8_t time);
+typedef void (*wiced_bt_mesh_app_notify_period_set_t)(uint8_t element_idx, uint16_t company_id, uint16_t model_id, uint32_t period);
+typedef uint32_t (*wiced_bt_mesh_app_proc_rx_cmd_t)(uint16_t opcode, uint8_t *p_data, uint32_t length);
+typedef void (*wiced_bt_mesh_app_lpn_sleep_t)(uint32_t max_sleep_duration);
+typedef void (*wiced_bt_mesh_app_factory_reset_t)(void);
+
+typedef struct
+{
+    wiced_bt_mesh_app_init_t                p_mesh_app_init;
+    wiced_bt_mesh_app_hardware_init_t       p_mesh_app_hw_init;
+    wiced_bt_mesh_app_gatt_conn_status_t    p_mesh_app_gatt_conn_status;
+    wiced_bt_mesh_app_attention_t           p_mesh_app_attention;
+    wiced_bt_mesh_app_notify_period_set_t   p_mesh_app_notify_period_set;
+    wiced_bt_mesh_app_proc_rx_cmd_t         p_mesh_app_proc_rx_cmd;
+    wiced_bt_mesh_app_lpn_sleep_t           p_mesh_app_lpn_sleep;
+    wiced_bt_mesh_app_factory_reset_t       p_mesh_app_factory_reset;
+} wiced_bt_mesh_app_func_table_t;
+
+wiced_bt_mesh_hci_event_t *wiced_bt_mesh_alloc_hci_event(uint8_t element_idx);
+uint8_t wiced_bt_mesh_get_element_idx_from_wiced_hci(uint8_t **p_data, uint32_t *length);
+wiced_result_t mesh_transport_send_data(uint16_t opcode, uint8_t *p_data, uint16_t length);
+void wiced_bt_mesh_set_raw_scan_response_data(uint8_t num_elem, wiced_bt_ble_advert_elem_t *p_adv_elem);
+
+/******************************************************
+ *          Simulation controls used by the host drivers
+ ******************************************************/
+#define HOST_MAX_ELEMENTS                                   64
+#define HOST_HCI_HEADER_LEN                                 5       // dst, app_key_idx and element_idx in front of the WICED HCI command payload
+
+extern wiced_bt_mesh_app_func_table_t wiced_bt_mesh_app_func_table;
+
+extern uint32_t host_hci_buffers;           // number of HCI event buffers, allocation fails while all of them wait for host_transport_drain
+extern uint64_t host_hci_events;            // number of HCI events sent
+extern uint64_t host_hci_bytes;             // number of bytes sent in HCI events
+extern uint64_t host_hci_alloc_fail;        // number of failed HCI event buffer allocations
+extern uint64_t host_onoff_changed;         // number of wiced_bt_mesh_model_onoff_changed calls
+extern uint64_t host_core_sends;            // number of messages sent to the mesh core
+extern uint64_t host_core_pdus;             // number of lower transport PDUs of the messages sent to the mesh core
+extern wiced_result_t host_core_send_result; // result of wiced_bt_mesh_core_send, messages are not sent unless WICED_SUCCESS
+extern uint64_t host_nvram_writes;          // number of successful NVRAM writes
+extern void (*host_hci_event_cback)(uint16_t opcode, uint8_t *p_data, uint16_t length);
+
+void host_onoff_status(uint8_t element_idx, uint8_t present_onoff, uint8_t target_onoff, uint32_t remaining_time);
+void host_transport_drain(void);
+void host_timers_run(uint32_t duration_ms);
+void host_nvram_erase(void);
+
+#endif // WICED_HOST_H
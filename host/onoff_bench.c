@@ -0,0 +1,238 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host benchmark of the mesh_onoff_server.c hot paths. The application is built unmodified against the stand-ins
+ * of wiced_host.c. The benchmark delivers OnOff Status events from the OnOff Server model, WICED HCI OnOff Set
+ * commands and OnOff Set Multi commands to the application and reports throughput, handler latency and number of
+ * bytes sent to the host MCU.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "wiced_host.h"
+
+#ifndef NUM_ONOFF_SERVERS
+#define NUM_ONOFF_SERVERS       1
+#endif
+
+// Application command defined in mesh_onoff_server.c
+#ifndef HCI_CONTROL_GROUP_ONOFF_SERVER
+#define HCI_CONTROL_GROUP_ONOFF_SERVER              0xe0
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI    ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x01)
+#endif
+
+#define BENCH_DEFAULT_OPS       1000000
+#define BENCH_TRANSITION_STEPS  10      // status events of an element during one transition, the last one reports the end
+#define BENCH_STATUS_INTERVAL   100     // milliseconds of simulated time between the status events of an element
+
+typedef struct
+{
+    const char  *name;
+    uint32_t    num_ops;
+    uint64_t    duration_ns;
+    uint64_t    hci_bytes;
+    uint64_t    changes;                // number of state changes reported by the application to the OnOff Server model
+    uint32_t    *p_latency_ns;
+} bench_result_t;
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_compare_u32(const void *p_a, const void *p_b)
+{
+    uint32_t a = *(const uint32_t *)p_a;
+    uint32_t b = *(const uint32_t *)p_b;
+
+    return (a > b) - (a < b);
+}
+
+static void bench_report(bench_result_t *p_result)
+{
+    double seconds = (double)p_result->duration_ns / 1e9;
+
+    qsort(p_result->p_latency_ns, p_result->num_ops, sizeof(uint32_t), bench_compare_u32);
+    printf("%-15s ops:%u ops/sec:%.0f p50:%uns p99:%uns bytes/op:%.2f", p_result->name, p_result->num_ops,
+        (seconds > 0) ? p_result->num_ops / seconds : 0.0,
+        p_result->p_latency_ns[p_result->num_ops / 2], p_result->p_latency_ns[(uint64_t)p_result->num_ops * 99 / 100],
+        (double)p_result->hci_bytes / p_result->num_ops);
+    if (p_result->changes != 0)
+        printf(" changes/sec:%.0f bytes/change:%.2f", (seconds > 0) ? p_result->changes / seconds : 0.0,
+            (double)p_result->hci_bytes / p_result->changes);
+    printf("\n");
+}
+
+/*
+ * Elements run transitions to alternating targets. Each element reports BENCH_TRANSITION_STEPS statuses per transition,
+ * the last one with 0 remaining time. Simulated time advances after a status of every element so that batch and
+ * retry timers expire as on the target.
+ */
+static void bench_status(bench_result_t *p_result)
+{
+    uint64_t start_ns, t0, bytes_start = host_hci_bytes;
+    uint32_t i, step, element_idx;
+    uint8_t  target;
+
+    start_ns = bench_now_ns();
+    for (i = 0; i < p_result->num_ops; i++)
+    {
+        element_idx = i % NUM_ONOFF_SERVERS;
+        step        = (i / NUM_ONOFF_SERVERS) % BENCH_TRANSITION_STEPS;
+        target      = (uint8_t)((i / NUM_ONOFF_SERVERS / BENCH_TRANSITION_STEPS) & 1);
+
+        t0 = bench_now_ns();
+        host_onoff_status((uint8_t)element_idx, (step == BENCH_TRANSITION_STEPS - 1) ? target : !target, target,
+            (BENCH_TRANSITION_STEPS - 1 - step) * BENCH_STATUS_INTERVAL);
+        p_result->p_latency_ns[i] = (uint32_t)(bench_now_ns() - t0);
+
+        if (element_idx == NUM_ONOFF_SERVERS - 1)
+            host_timers_run(BENCH_STATUS_INTERVAL);
+    }
+    p_result->duration_ns = bench_now_ns() - start_ns;
+    p_result->hci_bytes   = host_hci_bytes - bytes_start;
+}
+
+/*
+ * WICED HCI OnOff Set commands to all elements in turn. The model reports each change back with the OnOff Status
+ * event, so the latency and the bytes cover the command, the model, the status and the HCI event.
+ */
+static void bench_onoff_set(bench_result_t *p_result)
+{
+    uint8_t  cmd[HOST_HCI_HEADER_LEN + 1];
+    uint64_t start_ns, t0, bytes_start = host_hci_bytes, changes_start = host_onoff_changed;
+    uint32_t i;
+
+    memset(cmd, 0, sizeof(cmd));
+    start_ns = bench_now_ns();
+    for (i = 0; i < p_result->num_ops; i++)
+    {
+        cmd[HOST_HCI_HEADER_LEN - 1] = (uint8_t)(i % NUM_ONOFF_SERVERS);
+        cmd[HOST_HCI_HEADER_LEN]     = (uint8_t)((i / NUM_ONOFF_SERVERS) & 1);
+
+        t0 = bench_now_ns();
+        wiced_bt_mesh_app_func_table.p_mesh_app_proc_rx_cmd(HCI_CONTROL_MESH_COMMAND_ONOFF_SET, cmd, sizeof(cmd));
+        p_result->p_latency_ns[i] = (uint32_t)(bench_now_ns() - t0);
+    }
+    p_result->duration_ns = bench_now_ns() - start_ns;
+    p_result->hci_bytes   = host_hci_bytes - bytes_start;
+    p_result->changes     = host_onoff_changed - changes_start;
+}
+
+/*
+ * WICED HCI OnOff Set Multi commands, each one sets all elements to the opposite state. The bytes include
+ * the status of each element and the Set Multi Status event sent after each command.
+ */
+static void bench_onoff_set_multi(bench_result_t *p_result)
+{
+    uint8_t  cmd[HOST_HCI_HEADER_LEN + 2 * ((NUM_ONOFF_SERVERS + 7) / 8)];
+    uint8_t  *p_select = &cmd[HOST_HCI_HEADER_LEN], *p_onoff = p_select + (NUM_ONOFF_SERVERS + 7) / 8;
+    uint64_t start_ns, t0, bytes_start = host_hci_bytes, changes_start = host_onoff_changed;
+    uint32_t i;
+
+    memset(cmd, 0, sizeof(cmd));
+    for (i = 0; i < NUM_ONOFF_SERVERS; i++)
+        p_select[i / 8] |= (uint8_t)(1 << (i % 8));
+
+    start_ns = bench_now_ns();
+    for (i = 0; i < p_result->num_ops; i++)
+    {
+        memset(p_onoff, (i & 1) ? 0 : 0xff, (NUM_ONOFF_SERVERS + 7) / 8);
+
+        t0 = bench_now_ns();
+        wiced_bt_mesh_app_func_table.p_mesh_app_proc_rx_cmd(HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI, cmd, sizeof(cmd));
+        p_result->p_latency_ns[i] = (uint32_t)(bench_now_ns() - t0);
+    }
+    p_result->duration_ns = bench_now_ns() - start_ns;
+    p_result->hci_bytes   = host_hci_bytes - bytes_start;
+    p_result->changes     = host_onoff_changed - changes_start;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_result_t status = { "status" }, onoff_set = { "onoff_set" }, onoff_set_multi = { "onoff_set_multi" };
+    uint32_t       num_ops = BENCH_DEFAULT_OPS;
+
+    if (argc > 1)
+        num_ops = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (num_ops == 0)
+    {
+        fprintf(stderr, "usage: %s [number of operations]\n", argv[0]);
+        return 1;
+    }
+    status.num_ops         = num_ops;
+    status.p_latency_ns    = malloc(num_ops * sizeof(uint32_t));
+    onoff_set.num_ops      = num_ops;
+    onoff_set.p_latency_ns = malloc(num_ops * sizeof(uint32_t));
+    // same number of element changes as the onoff_set
+    onoff_set_multi.num_ops      = (num_ops + NUM_ONOFF_SERVERS - 1) / NUM_ONOFF_SERVERS;
+    onoff_set_multi.p_latency_ns = malloc(onoff_set_multi.num_ops * sizeof(uint32_t));
+    if ((status.p_latency_ns == NULL) || (onoff_set.p_latency_ns == NULL) || (onoff_set_multi.p_latency_ns == NULL))
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    wiced_bt_mesh_app_func_table.p_mesh_app_init(WICED_TRUE);
+
+    printf("elements:%d\n", NUM_ONOFF_SERVERS);
+    bench_status(&status);
+    bench_report(&status);
+    bench_onoff_set(&onoff_set);
+    bench_report(&onoff_set);
+    if (onoff_set.changes != onoff_set.num_ops)
+    {
+        fprintf(stderr, "onoff_set: %llu state changes for %u commands\n", (unsigned long long)onoff_set.changes, onoff_set.num_ops);
+        return 1;
+    }
+    bench_onoff_set_multi(&onoff_set_multi);
+    bench_report(&onoff_set_multi);
+    if (onoff_set_multi.changes != (uint64_t)onoff_set_multi.num_ops * NUM_ONOFF_SERVERS)
+    {
+        fprintf(stderr, "onoff_set_multi: %llu state changes for %u commands\n", (unsigned long long)onoff_set_multi.changes,
+            onoff_set_multi.num_ops);
+        return 1;
+    }
+
+    free(status.p_latency_ns);
+    free(onoff_set.p_latency_ns);
+    free(onoff_set_multi.p_latency_ns);
+    return 0;
+}
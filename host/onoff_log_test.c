@@ -0,0 +1,190 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host test of the OnOff state write-behind log (ONOFF_WRITE_BEHIND_SUPPORTED). Each round changes the state of
+ * several elements, with some changes reverted before the flush, and checks that the changes are written to NVRAM
+ * with a single write after the flush delay. The application is then initialized again as after a power cycle and
+ * the test checks that the state of the newest record is restored, also after the records wrapped around all slots.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "wiced_host.h"
+
+#ifndef NUM_ONOFF_SERVERS
+#define NUM_ONOFF_SERVERS       1
+#endif
+
+// Application settings defined in mesh_onoff_server.c
+#ifndef MESH_ONOFF_LOG_FLUSH_DELAY
+#define MESH_ONOFF_LOG_FLUSH_DELAY  5000
+#endif
+#define MESH_ONOFF_LOG_SLOTS        8
+#define MESH_ONOFF_NVRAM_ID_LOG_START   WICED_NVRAM_VSID_START
+
+#define LOG_TEST_DEFAULT_ROUNDS     (3 * MESH_ONOFF_LOG_SLOTS + 1)
+
+static uint8_t  log_test_state[NUM_ONOFF_SERVERS];      // target state set by the test
+static uint8_t  log_test_restored[NUM_ONOFF_SERVERS];   // target state reported by the application after power up
+static uint32_t log_test_changes;
+static uint32_t log_test_failures;
+
+/*
+ * Host side of the transport, remember the target state reported for each element
+ */
+static void log_test_hci_event(uint16_t opcode, uint8_t *p_data, uint16_t length)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event = (wiced_bt_mesh_hci_event_t *)p_data;
+
+    if ((opcode == HCI_CONTROL_MESH_EVENT_ONOFF_STATUS) && (p_hci_event->element_idx < NUM_ONOFF_SERVERS))
+        log_test_restored[p_hci_event->element_idx] = p_hci_event->data[1];
+}
+
+static void log_test_fail(const char *p_what, uint32_t round)
+{
+    printf("round:%u %s\n", round, p_what);
+    log_test_failures++;
+}
+
+static void log_test_set(uint8_t element_idx, uint8_t onoff)
+{
+    if (log_test_state[element_idx] == onoff)
+        return;
+    log_test_state[element_idx] = onoff;
+    log_test_changes++;
+    host_onoff_status(element_idx, onoff, onoff, 0);
+}
+
+/*
+ * Number of log slots written since the last erase
+ */
+static uint32_t log_test_slots_used(void)
+{
+    wiced_result_t result;
+    uint32_t       slot, num_used = 0;
+    uint8_t        byte;
+
+    for (slot = 0; slot < MESH_ONOFF_LOG_SLOTS; slot++)
+    {
+        if ((wiced_hal_read_nvram(MESH_ONOFF_NVRAM_ID_LOG_START + slot, 1, &byte, &result) == 1) && (result == WICED_SUCCESS))
+            num_used++;
+    }
+    return num_used;
+}
+
+/*
+ * Initialize the application as after a power cycle and check that it restores the state set by the test
+ */
+static void log_test_power_cycle(uint32_t round)
+{
+    uint64_t writes_start;
+    uint8_t  element_idx;
+
+    memset(log_test_restored, 0, sizeof(log_test_restored));
+    wiced_bt_mesh_app_func_table.p_mesh_app_init(WICED_TRUE);
+
+    for (element_idx = 0; element_idx < NUM_ONOFF_SERVERS; element_idx++)
+    {
+        if (log_test_restored[element_idx] != log_test_state[element_idx])
+        {
+            log_test_fail("restored state differs", round);
+            break;
+        }
+    }
+
+    // Restored state is already in the log
+    writes_start = host_nvram_writes;
+    host_timers_run(2 * MESH_ONOFF_LOG_FLUSH_DELAY);
+    if (host_nvram_writes != writes_start)
+        log_test_fail("restored state written again", round);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num_rounds = LOG_TEST_DEFAULT_ROUNDS, round;
+    uint64_t writes_start;
+    uint8_t  element_idx, last_idx = NUM_ONOFF_SERVERS - 1;
+
+    if (argc > 1)
+        num_rounds = (uint32_t)strtoul(argv[1], NULL, 0);
+
+    host_nvram_erase();
+    host_hci_event_cback = log_test_hci_event;
+    log_test_power_cycle(0);
+
+    for (round = 1; round <= num_rounds; round++)
+    {
+        writes_start = host_nvram_writes;
+
+        // Change reverted before the flush
+        log_test_set(last_idx, !log_test_state[last_idx]);
+        log_test_set(last_idx, !log_test_state[last_idx]);
+
+        // State of the round, element 0 changes in every round
+        for (element_idx = 0; element_idx < NUM_ONOFF_SERVERS; element_idx++)
+            log_test_set(element_idx, (uint8_t)((round >> (element_idx % 32)) & 1));
+
+        host_timers_run(MESH_ONOFF_LOG_FLUSH_DELAY - 1);
+        if (host_nvram_writes != writes_start)
+            log_test_fail("written before the flush delay", round);
+        host_timers_run(1);
+        if (host_nvram_writes != writes_start + 1)
+            log_test_fail("not written once after the flush delay", round);
+
+        // Only the reverted change, nothing to write
+        writes_start = host_nvram_writes;
+        log_test_set(last_idx, !log_test_state[last_idx]);
+        log_test_set(last_idx, !log_test_state[last_idx]);
+        host_timers_run(2 * MESH_ONOFF_LOG_FLUSH_DELAY);
+        if (host_nvram_writes != writes_start)
+            log_test_fail("reverted change written", round);
+
+        if (log_test_slots_used() != ((round < MESH_ONOFF_LOG_SLOTS) ? round : MESH_ONOFF_LOG_SLOTS))
+            log_test_fail("unexpected number of log slots", round);
+
+        log_test_power_cycle(round);
+    }
+
+    // Factory reset deletes the log, all elements are off after the power cycle
+    wiced_bt_mesh_app_func_table.p_mesh_app_factory_reset();
+    if (log_test_slots_used() != 0)
+        log_test_fail("log not deleted by factory reset", round);
+    memset(log_test_state, 0, sizeof(log_test_state));
+    log_test_power_cycle(round);
+
+    printf("elements:%d rounds:%u changes:%u nvram writes:%llu writes/change:%.3f failures:%u\n", NUM_ONOFF_SERVERS, num_rounds,
+        log_test_changes, (unsigned long long)host_nvram_writes, log_test_changes ? (double)host_nvram_writes / log_test_changes : 0.0,
+        log_test_failures);
+    return (log_test_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host stress test of the OnOff Status delivery to the host MCU under transport backpressure.
+ * The stand-in transport has only a few HCI event buffers, freed at random times. Random statuses of
+ * random elements are delivered to the application. After the last status of every element the transport
+ * recovers and the test checks that the host has received the final state of each element.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "wiced_host.h"
+
+#ifndef NUM_ONOFF_SERVERS
+#define NUM_ONOFF_SERVERS       1
+#endif
+
+// Application event defined in mesh_onoff_server.c
+#ifndef HCI_CONTROL_GROUP_ONOFF_SERVER
+#define HCI_CONTROL_GROUP_ONOFF_SERVER              0xe0
+#endif
+#ifndef HCI_CONTROL_MESH_EVENT_ONOFF_STATUS_BATCH
+#define HCI_CONTROL_MESH_EVENT_ONOFF_STATUS_BATCH   ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x81)
+#endif
+
+#define STRESS_DEFAULT_OPS      1000000
+#define STRESS_HCI_BUFFERS      2       // HCI event buffers of the stand-in transport
+#define STRESS_DRAIN_PERCENT    5       // probability that the host reads all events after a status
+#define STRESS_TIME_STEP        10      // milliseconds of simulated time between the statuses
+#define STRESS_RECOVERY_TIME    10000   // milliseconds given to the application to send the queued statuses at the end
+
+typedef struct
+{
+    uint8_t     valid;
+    uint8_t     present_onoff;
+    uint8_t     target_onoff;
+    uint32_t    remaining_time;
+} stress_state_t;
+
+static stress_state_t stress_sent[NUM_ONOFF_SERVERS];      // last status delivered to the application
+static stress_state_t stress_received[NUM_ONOFF_SERVERS];  // last status received by the host
+static uint32_t       stress_seed = 1;
+
+static uint32_t stress_rand(void)
+{
+    stress_seed = stress_seed * 1103515245 + 12345;
+    return (stress_seed >> 16) & 0x7fff;
+}
+
+static void stress_receive(uint8_t element_idx, uint8_t *p)
+{
+    if (element_idx >= NUM_ONOFF_SERVERS)
+        return;
+    stress_received[element_idx].valid = 1;
+    STREAM_TO_UINT8(stress_received[element_idx].present_onoff, p);
+    STREAM_TO_UINT8(stress_received[element_idx].target_onoff, p);
+    STREAM_TO_UINT32(stress_received[element_idx].remaining_time, p);
+}
+
+/*
+ * Host side of the transport, remember the last state of each element
+ */
+static void stress_hci_event(uint16_t opcode, uint8_t *p_data, uint16_t length)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event = (wiced_bt_mesh_hci_event_t *)p_data;
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+    uint8_t                   *p = p_hci_event->data;
+    uint8_t                   num_entries, element_idx;
+#endif
+
+    if (opcode == HCI_CONTROL_MESH_EVENT_ONOFF_STATUS)
+    {
+        stress_receive(p_hci_event->element_idx, p_hci_event->data);
+    }
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+    else if (opcode == HCI_CONTROL_MESH_EVENT_ONOFF_STATUS_BATCH)
+    {
+        STREAM_TO_UINT8(num_entries, p);
+        while (num_entries-- != 0)
+        {
+            STREAM_TO_UINT8(element_idx, p);
+            stress_receive(element_idx, p);
+            p += 6;
+        }
+    }
+#endif
+}
+
+static void stress_status(uint8_t element_idx, uint8_t present_onoff, uint8_t target_onoff, uint32_t remaining_time)
+{
+    stress_sent[element_idx].valid          = 1;
+    stress_sent[element_idx].present_onoff  = present_onoff;
+    stress_sent[element_idx].target_onoff   = target_onoff;
+    stress_sent[element_idx].remaining_time = remaining_time;
+    host_onoff_status(element_idx, present_onoff, target_onoff, remaining_time);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num_ops = STRESS_DEFAULT_OPS, i, time_ms, num_lost = 0;
+    uint8_t  element_idx, target;
+
+    if (argc > 1)
+        num_ops = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (argc > 2)
+        stress_seed = (uint32_t)strtoul(argv[2], NULL, 0);
+
+    wiced_bt_mesh_app_func_table.p_mesh_app_init(WICED_TRUE);
+    host_hci_event_cback = stress_hci_event;
+    host_hci_buffers     = STRESS_HCI_BUFFERS;
+
+    // Bursts of transitions while the host reads the events only now and then
+    for (i = 0; i < num_ops; i++)
+    {
+        element_idx = (uint8_t)(stress_rand() % NUM_ONOFF_SERVERS);
+        target      = (uint8_t)(stress_rand() & 1);
+        stress_status(element_idx, (uint8_t)(stress_rand() & 1), target, (stress_rand() % 50) * 100);
+
+        if ((stress_rand() % 100) < STRESS_DRAIN_PERCENT)
+            host_transport_drain();
+        host_timers_run(STRESS_TIME_STEP);
+    }
+
+    // Every element ends its transition while other events hold all HCI event buffers
+    while (wiced_bt_mesh_alloc_hci_event(0) != NULL)
+        ;
+    for (element_idx = 0; element_idx < NUM_ONOFF_SERVERS; element_idx++)
+    {
+        target = (uint8_t)(stress_rand() & 1);
+        stress_status(element_idx, target, target, 0);
+    }
+
+    // Transport recovers, the application shall deliver all final states
+    for (time_ms = 0; time_ms < STRESS_RECOVERY_TIME; time_ms += STRESS_TIME_STEP)
+    {
+        host_transport_drain();
+        host_timers_run(STRESS_TIME_STEP);
+    }
+
+    for (element_idx = 0; element_idx < NUM_ONOFF_SERVERS; element_idx++)
+    {
+        if (!stress_received[element_idx].valid ||
+            (stress_received[element_idx].present_onoff != stress_sent[element_idx].present_onoff) ||
+            (stress_received[element_idx].target_onoff != stress_sent[element_idx].target_onoff) ||
+            (stress_received[element_idx].remaining_time != stress_sent[element_idx].remaining_time))
+        {
+            printf("element:%d final state lost, sent %d/%d/%u received %d/%d/%u valid:%d\n", element_idx,
+                stress_sent[element_idx].present_onoff, stress_sent[element_idx].target_onoff, stress_sent[element_idx].remaining_time,
+                stress_received[element_idx].present_onoff, stress_received[element_idx].target_onoff, stress_received[element_idx].remaining_time,
+                stress_received[element_idx].valid);
+            num_lost++;
+        }
+    }
+    printf("elements:%d statuses:%u events:%llu alloc failures:%llu lost final states:%u\n", NUM_ONOFF_SERVERS,
+        num_ops + NUM_ONOFF_SERVERS, (unsigned long long)host_hci_events, (unsigned long long)host_hci_alloc_fail, num_lost);
+    return (num_lost == 0) ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host test of the vendor model multi element status (ONOFF_VENDOR_STATUS_SUPPORTED). Bursts of state changes of
+ * a growing number of elements are delivered to the application within one publication window. The test reports
+ * the messages and lower transport PDUs the application sends per state change, compared with one Generic OnOff
+ * Status per change, and checks that changes of a message the mesh core failed to send are published again.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "wiced_host.h"
+
+#ifndef NUM_ONOFF_SERVERS
+#define NUM_ONOFF_SERVERS       1
+#endif
+
+// Application setting defined in mesh_onoff_server.c
+#ifndef ONOFF_VENDOR_STATUS_WINDOW
+#define ONOFF_VENDOR_STATUS_WINDOW  50
+#endif
+
+static uint8_t  vendor_test_state[NUM_ONOFF_SERVERS];
+static uint32_t vendor_test_failures;
+
+/*
+ * Change state of the first num_elements elements and let the publication window expire
+ */
+static void vendor_test_burst(uint32_t num_elements)
+{
+    uint32_t element_idx;
+
+    for (element_idx = 0; element_idx < num_elements; element_idx++)
+    {
+        vendor_test_state[element_idx] = !vendor_test_state[element_idx];
+        host_onoff_status((uint8_t)element_idx, vendor_test_state[element_idx], vendor_test_state[element_idx], 0);
+    }
+    host_timers_run(ONOFF_VENDOR_STATUS_WINDOW);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint32_t burst_sizes[] = { 1, 2, 8, 16, 17, 24, 32, 64 };
+    uint64_t sends_start, pdus_start;
+    uint32_t i, num_elements;
+
+    wiced_bt_mesh_app_func_table.p_mesh_app_init(WICED_TRUE);
+
+    printf("elements:%d\n", NUM_ONOFF_SERVERS);
+    for (i = 0; (i < sizeof(burst_sizes) / sizeof(burst_sizes[0])) && (burst_sizes[i] <= NUM_ONOFF_SERVERS); i++)
+    {
+        num_elements = burst_sizes[i];
+        sends_start  = host_core_sends;
+        pdus_start   = host_core_pdus;
+        vendor_test_burst(num_elements);
+        if (host_core_sends - sends_start != 1)
+        {
+            printf("changed:%u messages:%llu, expected 1\n", num_elements, (unsigned long long)(host_core_sends - sends_start));
+            vendor_test_failures++;
+        }
+        printf("changed:%-3u messages:%llu pdus:%llu pdus/change:%.3f generic status pdus/change:1\n", num_elements,
+            (unsigned long long)(host_core_sends - sends_start), (unsigned long long)(host_core_pdus - pdus_start),
+            (double)(host_core_pdus - pdus_start) / num_elements);
+    }
+
+    // Mesh core fails to send, the changes are published after it recovers
+    host_core_send_result = WICED_ERROR;
+    sends_start = host_core_sends;
+    vendor_test_burst(1);
+    host_timers_run(3 * ONOFF_VENDOR_STATUS_WINDOW);
+    if (host_core_sends != sends_start)
+    {
+        printf("message counted as sent while the mesh core fails\n");
+        vendor_test_failures++;
+    }
+    host_core_send_result = WICED_SUCCESS;
+    host_timers_run(ONOFF_VENDOR_STATUS_WINDOW);
+    if (host_core_sends != sends_start + 1)
+    {
+        printf("changes not published after the mesh core recovered\n");
+        vendor_test_failures++;
+    }
+
+    printf("failures:%u\n", vendor_test_failures);
+    return (vendor_test_failures == 0) ? 0 : 1;
+}
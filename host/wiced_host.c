@@ -0,0 +1,361 @@
+/*
+* Copyright 2016-2023, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*/
+
+/** @file
+ *
+ * Host implementation of the BTSDK stand-ins declared in include/wiced_host.h.
+ * HCI transport, timers and NVRAM are simulated in memory and can be driven by the host drivers.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include "wiced_host.h"
+
+#define HOST_HCI_EVENT_MAX_LEN      1024
+#define HOST_NVRAM_IDS              64
+#define HOST_NVRAM_ITEM_MAX_LEN     512
+
+/******************************************************
+ *          Variables Definitions
+ ******************************************************/
+wiced_bt_cfg_settings_t wiced_bt_cfg_settings;
+
+int      host_trace_enabled;
+uint32_t host_hci_buffers;          // 0 means the transport never runs out of buffers
+uint64_t host_hci_events;
+uint64_t host_hci_bytes;
+uint64_t host_hci_alloc_fail;
+uint64_t host_onoff_changed;
+uint64_t host_core_sends;
+uint64_t host_core_pdus;
+wiced_result_t host_core_send_result = WICED_SUCCESS;
+uint64_t host_nvram_writes;
+void (*host_hci_event_cback)(uint16_t opcode, uint8_t *p_data, uint16_t length);
+
+static uint32_t host_hci_buffers_in_use;
+static uint8_t  host_hci_event_buf[HOST_HCI_EVENT_MAX_LEN];
+
+static wiced_bt_mesh_onoff_server_callback_t *host_onoff_server_cback[HOST_MAX_ELEMENTS];
+static wiced_bt_mesh_event_t host_mesh_event;
+
+static uint64_t      host_time_ms;
+static wiced_timer_t *host_timers;
+
+static uint16_t host_nvram_len[HOST_NVRAM_IDS];
+static uint8_t  host_nvram_data[HOST_NVRAM_IDS][HOST_NVRAM_ITEM_MAX_LEN];
+
+/******************************************************
+ *          Trace
+ ******************************************************/
+void host_trace(const char *p_fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, p_fmt);
+    vprintf(p_fmt, ap);
+    va_end(ap);
+}
+
+/******************************************************
+ *          WICED HCI transport
+ ******************************************************/
+wiced_bt_mesh_hci_event_t *wiced_bt_mesh_alloc_hci_event(uint8_t element_idx)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event = (wiced_bt_mesh_hci_event_t *)host_hci_event_buf;
+
+    if ((host_hci_buffers != 0) && (host_hci_buffers_in_use >= host_hci_buffers))
+    {
+        host_hci_alloc_fail++;
+        return NULL;
+    }
+    host_hci_buffers_in_use++;
+    memset(p_hci_event, 0, offsetof(wiced_bt_mesh_hci_event_t, data));
+    p_hci_event->element_idx = element_idx;
+    return p_hci_event;
+}
+
+wiced_result_t mesh_transport_send_data(uint16_t opcode, uint8_t *p_data, uint16_t length)
+{
+    host_hci_events++;
+    host_hci_bytes += length;
+    if (host_hci_event_cback != NULL)
+        host_hci_event_cback(opcode, p_data, length);
+    // buffers are returned to the pool when the host reads them, unless the pool is unlimited
+    if (host_hci_buffers == 0)
+        host_hci_buffers_in_use = 0;
+    return WICED_SUCCESS;
+}
+
+/*
+ * Host has read all events sent so far, their buffers are free again
+ */
+void host_transport_drain(void)
+{
+    host_hci_buffers_in_use = 0;
+}
+
+/*
+ * Command payload starts with the destination, application key index and element index
+ */
+uint8_t wiced_bt_mesh_get_element_idx_from_wiced_hci(uint8_t **p_data, uint32_t *length)
+{
+    uint8_t element_idx = (*p_data)[HOST_HCI_HEADER_LEN - 1];
+
+    *p_data += HOST_HCI_HEADER_LEN;
+    *length -= HOST_HCI_HEADER_LEN;
+    return element_idx;
+}
+
+void wiced_bt_mesh_set_raw_scan_response_data(uint8_t num_elem, wiced_bt_ble_advert_elem_t *p_adv_elem)
+{
+}
+
+/******************************************************
+ *          Mesh core and models
+ ******************************************************/
+void wiced_bt_mesh_model_onoff_server_init(uint8_t element_idx, wiced_bt_mesh_onoff_server_callback_t *p_callback, uint32_t report_interval, wiced_bool_t is_provisioned)
+{
+    if (element_idx < HOST_MAX_ELEMENTS)
+        host_onoff_server_cback[element_idx] = p_callback;
+}
+
+/*
+ * Local change of the OnOff state. The model sets the state without a transition and reports the new state
+ * to the application with the OnOff Status event, as it does on the target.
+ */
+void wiced_bt_mesh_model_onoff_changed(uint8_t element_idx, uint8_t onoff)
+{
+    host_onoff_changed++;
+    host_onoff_status(element_idx, onoff, onoff, 0);
+}
+
+/*
+ * Deliver OnOff Status of the element to the application as the OnOff Server model does during a transition
+ */
+void host_onoff_status(uint8_t element_idx, uint8_t present_onoff, uint8_t target_onoff, uint32_t remaining_time)
+{
+    wiced_bt_mesh_onoff_status_data_t status;
+
+    if ((element_idx >= HOST_MAX_ELEMENTS) || (host_onoff_server_cback[element_idx] == NULL))
+        return;
+
+    status.present_onoff  = present_onoff;
+    status.target_onoff   = target_onoff;
+    status.remaining_time = remaining_time;
+    host_onoff_server_cback[element_idx](element_idx, WICED_BT_MESH_ONOFF_STATUS, &status);
+}
+
+wiced_bt_mesh_event_t *wiced_bt_mesh_create_event(uint8_t element_idx, uint16_t company_id, uint16_t model_id, uint16_t dst, uint16_t app_key_idx)
+{
+    memset(&host_mesh_event, 0, sizeof(host_mesh_event));
+    host_mesh_event.element_idx = element_idx;
+    host_mesh_event.company_id  = company_id;
+    host_mesh_event.model_id    = model_id;
+    host_mesh_event.dst         = dst;
+    host_mesh_event.app_key_idx = app_key_idx;
+    return &host_mesh_event;
+}
+
+void wiced_bt_mesh_release_event(wiced_bt_mesh_event_t *p_event)
+{
+}
+
+/*
+ * Count the message and the lower transport PDUs it takes. An access payload of up to 11 bytes fits an unsegmented
+ * PDU with the 4 byte TransMIC, a longer one is split in segments of 12 bytes. Vendor opcodes take 3 bytes, SIG ones 2.
+ */
+wiced_result_t wiced_bt_mesh_core_send(wiced_bt_mesh_event_t *p_event, const uint8_t *params, uint16_t params_len, wiced_bt_mesh_core_send_complete_callback_t complete_callback)
+{
+    uint32_t access_len = params_len + ((p_event->company_id == MESH_COMPANY_ID_BT_SIG) ? 2 : 3);
+
+    if (host_core_send_result != WICED_SUCCESS)
+        return host_core_send_result;
+
+    host_core_sends++;
+    host_core_pdus += (access_len <= 11) ? 1 : (access_len + 4 + 11) / 12;
+    return WICED_SUCCESS;
+}
+
+void wiced_bt_mesh_remote_provisioning_server_init(void)
+{
+}
+
+void wiced_bt_mesh_model_fw_distribution_server_init(void)
+{
+}
+
+void wiced_bt_mesh_directed_forwarding_init(wiced_bool_t directed_proxy_supported, wiced_bool_t directed_friend_supported, int8_t default_rssi_threshold,
+    uint8_t max_dt_entries_cnt, uint8_t node_paths, uint8_t relay_paths, uint8_t proxy_paths, uint8_t friend_paths)
+{
+}
+
+void wiced_bt_mesh_network_filter_init(void)
+{
+}
+
+/******************************************************
+ *          Timers
+ ******************************************************/
+wiced_result_t wiced_init_timer(wiced_timer_t *p_timer, wiced_timer_callback_t *p_cb, TIMER_PARAM_TYPE cb_param, uint8_t timer_type)
+{
+    wiced_stop_timer(p_timer);
+    p_timer->p_cback     = p_cb;
+    p_timer->cback_param = cb_param;
+    p_timer->type        = timer_type;
+    return WICED_SUCCESS;
+}
+
+wiced_result_t wiced_start_timer(wiced_timer_t *p_timer, uint32_t timeout)
+{
+    wiced_stop_timer(p_timer);
+    if ((p_timer->type == WICED_SECONDS_TIMER) || (p_timer->type == WICED_SECONDS_PERIODIC_TIMER))
+        timeout *= 1000;
+    p_timer->timeout_ms = timeout;
+    p_timer->expire_ms  = host_time_ms + timeout;
+    p_timer->in_use     = WICED_TRUE;
+    p_timer->p_next     = host_timers;
+    host_timers         = p_timer;
+    return WICED_SUCCESS;
+}
+
+wiced_result_t wiced_stop_timer(wiced_timer_t *p_timer)
+{
+    wiced_timer_t **pp;
+
+    for (pp = &host_timers; *pp != NULL; pp = &(*pp)->p_next)
+    {
+        if (*pp == p_timer)
+        {
+            *pp = p_timer->p_next;
+            break;
+        }
+    }
+    p_timer->in_use = WICED_FALSE;
+    return WICED_SUCCESS;
+}
+
+wiced_bool_t wiced_is_timer_in_use(wiced_timer_t *p_timer)
+{
+    return p_timer->in_use;
+}
+
+/*
+ * Advance the simulated time firing the timers in the order of their expiration
+ */
+void host_timers_run(uint32_t duration_ms)
+{
+    uint64_t      end_ms = host_time_ms + duration_ms;
+    wiced_timer_t *p_timer, *p_first;
+    uint32_t      period_ms;
+
+    for (;;)
+    {
+        p_first = NULL;
+        for (p_timer = host_timers; p_timer != NULL; p_timer = p_timer->p_next)
+        {
+            if ((p_timer->expire_ms <= end_ms) && ((p_first == NULL) || (p_timer->expire_ms < p_first->expire_ms)))
+                p_first = p_timer;
+        }
+        if (p_first == NULL)
+            break;
+
+        host_time_ms = p_first->expire_ms;
+        wiced_stop_timer(p_first);
+        if ((p_first->type == WICED_SECONDS_PERIODIC_TIMER) || (p_first->type == WICED_MILLI_SECONDS_PERIODIC_TIMER))
+        {
+            period_ms = p_first->timeout_ms;
+            wiced_start_timer(p_first, 0);
+            p_first->timeout_ms = period_ms;
+            p_first->expire_ms  = host_time_ms + period_ms;
+        }
+        p_first->p_cback(p_first->cback_param);
+    }
+    host_time_ms = end_ms;
+}
+
+uint64_t clock_SystemTimeMicroseconds64(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/******************************************************
+ *          NVRAM
+ ******************************************************/
+uint16_t wiced_hal_write_nvram(uint16_t vs_id, uint16_t data_length, uint8_t *p_data, wiced_result_t *p_status)
+{
+    uint16_t idx = vs_id - WICED_NVRAM_VSID_START;
+
+    if ((vs_id < WICED_NVRAM_VSID_START) || (idx >= HOST_NVRAM_IDS) || (data_length > HOST_NVRAM_ITEM_MAX_LEN))
+    {
+        *p_status = WICED_ERROR;
+        return 0;
+    }
+    memcpy(host_nvram_data[idx], p_data, data_length);
+    host_nvram_len[idx] = data_length;
+    host_nvram_writes++;
+    *p_status = WICED_SUCCESS;
+    return data_length;
+}
+
+uint16_t wiced_hal_read_nvram(uint16_t vs_id, uint16_t data_length, uint8_t *p_data, wiced_result_t *p_status)
+{
+    uint16_t idx = vs_id - WICED_NVRAM_VSID_START;
+
+    if ((vs_id < WICED_NVRAM_VSID_START) || (idx >= HOST_NVRAM_IDS) || (host_nvram_len[idx] == 0))
+    {
+        *p_status = WICED_ERROR;
+        return 0;
+    }
+    if (data_length > host_nvram_len[idx])
+        data_length = host_nvram_len[idx];
+    memcpy(p_data, host_nvram_data[idx], data_length);
+    *p_status = WICED_SUCCESS;
+    return data_length;
+}
+
+void wiced_hal_delete_nvram(uint16_t vs_id, wiced_result_t *p_status)
+{
+    uint16_t idx = vs_id - WICED_NVRAM_VSID_START;
+
+    if ((vs_id >= WICED_NVRAM_VSID_START) && (idx < HOST_NVRAM_IDS))
+        host_nvram_len[idx] = 0;
+    *p_status = WICED_SUCCESS;
+}
+
+void host_nvram_erase(void)
+{
+    memset(host_nvram_len, 0, sizeof(host_nvram_len));
+}
@@ -43,6 +43,10 @@
 #include "wiced_bt_mesh_dfu.h"
 #endif
 #include "wiced_bt_trace.h"
+#include "wiced_timer.h"
+#if defined(ONOFF_WRITE_BEHIND_SUPPORTED) || defined(ONOFF_SCENES_SUPPORTED)
+#include "wiced_hal_nvram.h"
+#endif
 #include "wiced_bt_mesh_app.h"
 #if ( defined(DIRECTED_FORWARDING_SERVER_SUPPORTED) || defined(NETWORK_FILTER_SERVER_SUPPORTED))
 #include "wiced_bt_mesh_mdf.h"
@@ -66,9 +70,25 @@
 #include "wiced_bt_cfg.h"
 extern wiced_bt_cfg_settings_t wiced_bt_cfg_settings;
 
+#ifndef NUM_ONOFF_SERVERS
 #define NUM_ONOFF_SERVERS       1
+#endif
 #define TRANSITION_INTERVAL     100     // receive status notifications every 100ms during transition to new state
 
+// Policies to report status received during transition to the host, can be changed per element at runtime
+#define MESH_ONOFF_REPORT_POLICY_INTERVAL       0   // report every status notification
+#define MESH_ONOFF_REPORT_POLICY_ON_CHANGE      1   // report only if present or target state has changed
+#define MESH_ONOFF_REPORT_POLICY_START_END      2   // report at the start (target state has changed) and at the end of transition
+#define MESH_ONOFF_REPORT_POLICY_ADAPTIVE       3   // report on change and about MESH_ONOFF_ADAPTIVE_REPORTS times during the remaining transition time
+
+#ifndef MESH_ONOFF_REPORT_POLICY_DEFAULT
+#define MESH_ONOFF_REPORT_POLICY_DEFAULT        MESH_ONOFF_REPORT_POLICY_INTERVAL
+#endif
+#if MESH_ONOFF_REPORT_POLICY_DEFAULT > MESH_ONOFF_REPORT_POLICY_ADAPTIVE
+#error "MESH_ONOFF_REPORT_POLICY_DEFAULT shall be from 0 to 3"
+#endif
+#define MESH_ONOFF_ADAPTIVE_REPORTS             4
+
 // Needed to pass some PTS tests which require vendor model
 //#define MESH_VENDOR_TST_COMPANY_ID  0x131
 //#define MESH_VENDOR_TST_MODEL_ID    1
@@ -80,35 +100,467 @@ extern wiced_bt_cfg_settings_t wiced_bt_cfg_settings;
 #define MESH_VID                0x0002
 
 // Definitions for parameters of the wiced_bt_mesh_directed_forwarding_init():
-#define MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED   WICED_TRUE  // WICED_TRUE if directed proxy is supported.
-#define MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED  WICED_TRUE  // WICED_TRUE if directed friend is supported.
+#ifndef MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED
+#define MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED   1           // 1 (WICED_TRUE) if directed proxy is supported.
+#endif
+#ifndef MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED
+#define MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED  1           // 1 (WICED_TRUE) if directed friend is supported.
+#endif
 #define MESH_DIRECTED_FORWARDING_DEFAULT_RSSI_THRESHOLD     -120        // The value of the default_rssi_threshold is implementation specificand should be 10 dB above the receiver sensitivity.
+#ifndef MESH_DIRECTED_FORWARDING_MAX_DT_ENTRIES_CNT
 #define MESH_DIRECTED_FORWARDING_MAX_DT_ENTRIES_CNT         2           // The maximum number of Discovery Table entries supported by the node in a given subnet.It shall be >= 2.
-#define MESH_DIRECTED_FORWARDING_NODE_PATHS                 20          // The minimum number of paths that the node supports when acting as a Path Origin or as a Path Target.It shall be >= 20.
-#define MESH_DIRECTED_FORWARDING_RELAY_PATHS                20          // The minimum number of paths that the node supports when acting as an intermediate Directed Relay node.It shall be >= 20.
-#define MESH_DIRECTED_FORWARDING_PROXY_PATHS                20          // The minimum number of paths that the node supports when acting as a Directed Proxy node. If directed proxy is supported, it shall be >= 20; otherwise it shall be 0.
-#define MESH_DIRECTED_FORWARDING_FRIEND_PATHS               20          // The minimum number of paths that the node supports when acting as a Directed Friend node.
+#endif
+
+// Minimum number of paths of each role. Node, relay and proxy minimums are required by the spec. The spec sets no minimum
+// for the friend role, 20 keeps the friend paths of the default configuration.
+#define MESH_DIRECTED_FORWARDING_MIN_NODE_PATHS             20
+#define MESH_DIRECTED_FORWARDING_MIN_RELAY_PATHS            20
+#define MESH_DIRECTED_FORWARDING_MIN_PROXY_PATHS            (MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED ? 20 : 0)
+#ifndef MESH_DIRECTED_FORWARDING_MIN_FRIEND_PATHS
+#define MESH_DIRECTED_FORWARDING_MIN_FRIEND_PATHS           (MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED ? 20 : 0)
+#endif
+#define MESH_DIRECTED_FORWARDING_MIN_PATHS                  (MESH_DIRECTED_FORWARDING_MIN_NODE_PATHS + MESH_DIRECTED_FORWARDING_MIN_RELAY_PATHS + \
+                                                             MESH_DIRECTED_FORWARDING_MIN_PROXY_PATHS + MESH_DIRECTED_FORWARDING_MIN_FRIEND_PATHS)
+
+// MESH_DIRECTED_FORWARDING_PATH_BUDGET is the total number of paths the node allocates for all roles. If it is 0, each role gets its minimum.
+// Otherwise each role gets its minimum, the rest of the budget is split evenly between the supported roles and the remainder is added to the relay paths.
+#ifndef MESH_DIRECTED_FORWARDING_PATH_BUDGET
+#define MESH_DIRECTED_FORWARDING_PATH_BUDGET                0
+#endif
+
+#if MESH_DIRECTED_FORWARDING_PATH_BUDGET == 0
+#define MESH_DIRECTED_FORWARDING_SPARE_PATHS                0
+#define MESH_DIRECTED_FORWARDING_REMAINDER_PATHS            0
+#elif MESH_DIRECTED_FORWARDING_PATH_BUDGET < MESH_DIRECTED_FORWARDING_MIN_PATHS
+#error "MESH_DIRECTED_FORWARDING_PATH_BUDGET is less than the sum of the minimum paths of the supported roles: 20 node, 20 relay, 20 proxy and 20 friend paths"
+#define MESH_DIRECTED_FORWARDING_SPARE_PATHS                0
+#define MESH_DIRECTED_FORWARDING_REMAINDER_PATHS            0
+#else
+#define MESH_DIRECTED_FORWARDING_SUPPORTED_ROLES            (2 + (MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED ? 1 : 0) + (MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED ? 1 : 0))
+#define MESH_DIRECTED_FORWARDING_SPARE_PATHS                ((MESH_DIRECTED_FORWARDING_PATH_BUDGET - MESH_DIRECTED_FORWARDING_MIN_PATHS) / MESH_DIRECTED_FORWARDING_SUPPORTED_ROLES)
+#define MESH_DIRECTED_FORWARDING_REMAINDER_PATHS            ((MESH_DIRECTED_FORWARDING_PATH_BUDGET - MESH_DIRECTED_FORWARDING_MIN_PATHS) % MESH_DIRECTED_FORWARDING_SUPPORTED_ROLES)
+#endif
+
+#ifndef MESH_DIRECTED_FORWARDING_NODE_PATHS
+#define MESH_DIRECTED_FORWARDING_NODE_PATHS                 (MESH_DIRECTED_FORWARDING_MIN_NODE_PATHS + MESH_DIRECTED_FORWARDING_SPARE_PATHS)    // The minimum number of paths that the node supports when acting as a Path Origin or as a Path Target.It shall be >= 20.
+#endif
+#ifndef MESH_DIRECTED_FORWARDING_RELAY_PATHS
+#define MESH_DIRECTED_FORWARDING_RELAY_PATHS                (MESH_DIRECTED_FORWARDING_MIN_RELAY_PATHS + MESH_DIRECTED_FORWARDING_SPARE_PATHS + MESH_DIRECTED_FORWARDING_REMAINDER_PATHS)  // The minimum number of paths that the node supports when acting as an intermediate Directed Relay node.It shall be >= 20.
+#endif
+#ifndef MESH_DIRECTED_FORWARDING_PROXY_PATHS
+#define MESH_DIRECTED_FORWARDING_PROXY_PATHS                (MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED ? MESH_DIRECTED_FORWARDING_MIN_PROXY_PATHS + MESH_DIRECTED_FORWARDING_SPARE_PATHS : 0)  // The minimum number of paths that the node supports when acting as a Directed Proxy node. If directed proxy is supported, it shall be >= 20; otherwise it shall be 0.
+#endif
+#ifndef MESH_DIRECTED_FORWARDING_FRIEND_PATHS
+#define MESH_DIRECTED_FORWARDING_FRIEND_PATHS               (MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED ? MESH_DIRECTED_FORWARDING_MIN_FRIEND_PATHS + MESH_DIRECTED_FORWARDING_SPARE_PATHS : 0)  // The minimum number of paths that the node supports when acting as a Directed Friend node.
+#endif
+
+#if MESH_DIRECTED_FORWARDING_MAX_DT_ENTRIES_CNT < 2
+#error "MESH_DIRECTED_FORWARDING_MAX_DT_ENTRIES_CNT shall be >= 2"
+#endif
+#if (MESH_DIRECTED_FORWARDING_NODE_PATHS < MESH_DIRECTED_FORWARDING_MIN_NODE_PATHS) || (MESH_DIRECTED_FORWARDING_RELAY_PATHS < MESH_DIRECTED_FORWARDING_MIN_RELAY_PATHS)
+#error "MESH_DIRECTED_FORWARDING_NODE_PATHS and MESH_DIRECTED_FORWARDING_RELAY_PATHS shall be >= 20"
+#endif
+#if (MESH_DIRECTED_FORWARDING_PROXY_PATHS < MESH_DIRECTED_FORWARDING_MIN_PROXY_PATHS) || (!MESH_DIRECTED_FORWARDING_DIRECTED_PROXY_SUPPORTED && (MESH_DIRECTED_FORWARDING_PROXY_PATHS != 0))
+#error "MESH_DIRECTED_FORWARDING_PROXY_PATHS shall be >= 20 if directed proxy is supported, otherwise it shall be 0"
+#endif
+#if (MESH_DIRECTED_FORWARDING_NODE_PATHS > 255) || (MESH_DIRECTED_FORWARDING_RELAY_PATHS > 255) || \
+    (MESH_DIRECTED_FORWARDING_PROXY_PATHS > 255) || (MESH_DIRECTED_FORWARDING_FRIEND_PATHS > 255)
+#error "Number of directed forwarding paths of each role shall be <= 255, reduce MESH_DIRECTED_FORWARDING_PATH_BUDGET"
+#endif
+#if MESH_DIRECTED_FORWARDING_DIRECTED_FRIEND_SUPPORTED && (MESH_DIRECTED_FORWARDING_FRIEND_PATHS == 0)
+#error "MESH_DIRECTED_FORWARDING_FRIEND_PATHS shall be > 0 if directed friend is supported"
+#endif
+#if (MESH_DIRECTED_FORWARDING_PATH_BUDGET >= MESH_DIRECTED_FORWARDING_MIN_PATHS) && ((MESH_DIRECTED_FORWARDING_NODE_PATHS + MESH_DIRECTED_FORWARDING_RELAY_PATHS + MESH_DIRECTED_FORWARDING_PROXY_PATHS + MESH_DIRECTED_FORWARDING_FRIEND_PATHS) > MESH_DIRECTED_FORWARDING_PATH_BUDGET)
+#error "Number of directed forwarding paths exceeds MESH_DIRECTED_FORWARDING_PATH_BUDGET"
+#endif
+
+// Configuration of the Friend feature used when the node is not a Low Power Node
+#ifndef MESH_FRIEND_CACHE_BUF_LEN
+#define MESH_FRIEND_CACHE_BUF_LEN                           300         // Length of the buffer for the cache
+#endif
+#ifndef MESH_FRIEND_MAX_LPN_NUM
+#define MESH_FRIEND_MAX_LPN_NUM                             4           // Max number of Low Power Nodes with established friendship
+#endif
+#if !defined(LOW_POWER_NODE) || (LOW_POWER_NODE == 0)
+#if MESH_FRIEND_MAX_LPN_NUM < 1
+#error "MESH_FRIEND_MAX_LPN_NUM must be > 0 if Friend feature is supported"
+#endif
+#if MESH_FRIEND_MAX_LPN_NUM > 255
+#error "MESH_FRIEND_MAX_LPN_NUM must be <= 255, max_lpn_num is 8 bits"
+#endif
+#if MESH_FRIEND_CACHE_BUF_LEN < 1
+#error "MESH_FRIEND_CACHE_BUF_LEN must be > 0 if Friend feature is supported"
+#endif
+#if MESH_FRIEND_CACHE_BUF_LEN > 65535
+#error "MESH_FRIEND_CACHE_BUF_LEN must be <= 65535, cache_buf_len is 16 bits"
+#endif
+#endif
+
+// Configuration of the Low Power feature. Shorter poll timeout reduces the latency of the OnOff commands queued by the Friend,
+// longer poll timeout reduces the number of wake ups when there is no traffic.
+#ifndef MESH_LPN_RECEIVE_DELAY
+#define MESH_LPN_RECEIVE_DELAY                              100         // Receive delay in 1 ms units to be requested by the Low Power node.
+#endif
+#ifndef MESH_LPN_POLL_TIMEOUT
+#define MESH_LPN_POLL_TIMEOUT                               200         // Poll timeout in 100ms units to be requested by the Low Power node.
+#endif
+#if defined(LOW_POWER_NODE) && (LOW_POWER_NODE == 1)
+#if (MESH_LPN_RECEIVE_DELAY < 10) || (MESH_LPN_RECEIVE_DELAY > 255)
+#error "MESH_LPN_RECEIVE_DELAY shall be from 10 to 255 ms"
+#endif
+#if (MESH_LPN_POLL_TIMEOUT < 10) || (MESH_LPN_POLL_TIMEOUT > 0x34BBFF)
+#error "MESH_LPN_POLL_TIMEOUT shall be from 10 (1 second) to 0x34BBFF (96 hours) in 100 ms units"
+#endif
+#endif
+
+#ifdef HCI_CONTROL
+// Application specific WICED HCI commands and events. They use their own group, so that they cannot collide with the commands
+// and events of the mesh group defined in hci_control_api.h, including the core test commands. The group is above the groups
+// defined by the SDK, define HCI_CONTROL_GROUP_ONOFF_SERVER to move it if it is used by another module of the host.
+#ifndef HCI_CONTROL_GROUP_ONOFF_SERVER
+#define HCI_CONTROL_GROUP_ONOFF_SERVER                      0xe0
+#endif
+#if (HCI_CONTROL_GROUP_ONOFF_SERVER == HCI_CONTROL_GROUP_MESH) || (HCI_CONTROL_GROUP_ONOFF_SERVER == 0x00) || (HCI_CONTROL_GROUP_ONOFF_SERVER >= 0xff)
+#error "HCI_CONTROL_GROUP_ONOFF_SERVER shall not be the mesh, device or miscellaneous group"
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI            ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x01)  // Set OnOff state of several elements, payload is a select mask followed by an OnOff mask
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET    ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x02)  // Set status report policy, payload is the policy and optional number of elements
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET            ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x03)  // Get counters and latency histograms, payload is optional reset flag
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE          ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x04)  // Store scene, payload is scene index, mask length, select mask and OnOff mask. With mask length 0 current state of all elements is stored.
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL         ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x05)  // Recall scene, payload is scene index
+#endif
+#ifndef HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE
+#define HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE         ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x06)  // Delete scene, payload is scene index
+#endif
+#ifndef HCI_CONTROL_MESH_EVENT_ONOFF_STATUS_BATCH
+#define HCI_CONTROL_MESH_EVENT_ONOFF_STATUS_BATCH           ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x81)  // Present/target/remaining time of all elements changed within the batch window
+#endif
+#ifndef HCI_CONTROL_MESH_EVENT_ONOFF_SET_MULTI_STATUS
+#define HCI_CONTROL_MESH_EVENT_ONOFF_SET_MULTI_STATUS       ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x82)  // Number of elements changed by the HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI
+#endif
+#ifndef HCI_CONTROL_MESH_EVENT_ONOFF_STATS
+#define HCI_CONTROL_MESH_EVENT_ONOFF_STATS                  ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x83)  // Content of the mesh_onoff_stats_t, each value is 4 bytes, followed by mesh_onoff_boot_time, each value is 8 bytes
+#endif
+#ifndef HCI_CONTROL_MESH_EVENT_ONOFF_SCENE_STATUS
+#define HCI_CONTROL_MESH_EVENT_ONOFF_SCENE_STATUS           ((HCI_CONTROL_GROUP_ONOFF_SERVER << 8) | 0x84)  // Result of a scene command: scene index, status, number of elements changed
+#endif
+#endif
+
+// NVRAM IDs used by the application
+#define MESH_ONOFF_LOG_SLOTS                                8           // Number of NVRAM IDs the OnOff state log records rotate through
+#define MESH_ONOFF_SCENES_MAX                               16          // Max number of OnOff scenes, each scene is saved with its own NVRAM ID
+#define MESH_ONOFF_NVRAM_ID_LOG_START                       WICED_NVRAM_VSID_START
+#define MESH_ONOFF_NVRAM_ID_SCENE_START                     (MESH_ONOFF_NVRAM_ID_LOG_START + MESH_ONOFF_LOG_SLOTS)
+
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+// OnOff state is saved by the application: changes are collected in RAM and written as a record to the next NVRAM slot
+// of the log after a delay. On power up the newest record is restored, so the models library shall not restore the state.
+#define MESH_ONOFF_ONPOWERUP_STATE                          WICED_BT_MESH_ON_POWER_UP_STATE_OFF
+#ifndef MESH_ONOFF_LOG_FLUSH_DELAY
+#define MESH_ONOFF_LOG_FLUSH_DELAY                          5000        // Changes are written this many milliseconds after the first unsaved change
+#endif
+#else
+#define MESH_ONOFF_ONPOWERUP_STATE                          WICED_BT_MESH_ON_POWER_UP_STATE_RESTORE
+#endif
+
+#ifdef HCI_CONTROL
+#define MESH_ONOFF_STATUS_RETRY_DELAY                       20          // Delay in milliseconds before retrying to send status which did not get a HCI event buffer
+#ifndef MESH_ONOFF_STATUS_QUEUE_SIZE
+#define MESH_ONOFF_STATUS_QUEUE_SIZE                        NUM_ONOFF_SERVERS   // Elements waiting for a HCI event buffer. With an entry per element the final state is never lost.
+#endif
+#endif
+
+#if defined(ONOFF_STATUS_BATCH_SUPPORTED) && !defined(HCI_CONTROL)
+#undef ONOFF_STATUS_BATCH_SUPPORTED     // status batches are only sent to the host over WICED HCI
+#endif
+
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+#ifndef ONOFF_STATUS_BATCH_WINDOW
+#define ONOFF_STATUS_BATCH_WINDOW                           50          // Status changes are collected for this many milliseconds before being sent to the host in one event
+#endif
+#define ONOFF_STATUS_BATCH_MAX_ENTRIES                      16          // Batch is sent immediately when this many elements are pending. 7 bytes per entry must fit into the HCI event.
+#endif
+
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+// Vendor model which publishes OnOff state changes of all elements in one message. Clients opt in by configuring
+// publication of the model, Generic OnOff Status of each element is still published by the OnOff Server models.
+#ifndef MESH_ONOFF_VENDOR_COMPANY_ID
+#define MESH_ONOFF_VENDOR_COMPANY_ID                        MESH_COMPANY_ID_CYPRESS
+#endif
+#ifndef MESH_ONOFF_VENDOR_MODEL_ID
+#define MESH_ONOFF_VENDOR_MODEL_ID                          0x0010
+#endif
+#define MESH_ONOFF_VENDOR_OPCODE_MULTI_STATUS               0x01        // Changed elements mask, present OnOff mask and target OnOff mask of the same length
+#ifndef ONOFF_VENDOR_STATUS_WINDOW
+#define ONOFF_VENDOR_STATUS_WINDOW                          50          // State changes are collected for this many milliseconds before being published in one message
+#endif
+#endif
+
+#if defined(ONOFF_DEFERRED_TRACE_SUPPORTED) && !defined(WICED_BT_TRACE_ENABLE)
+#undef ONOFF_DEFERRED_TRACE_SUPPORTED   // nothing to format when the traces are compiled out
+#endif
+
+#ifdef ONOFF_DEFERRED_TRACE_SUPPORTED
+#ifndef MESH_ONOFF_TRACE_RING_SIZE
+#define MESH_ONOFF_TRACE_RING_SIZE                          32          // Number of trace records in the ring buffer, shall be a power of 2
+#endif
+#ifndef MESH_ONOFF_TRACE_DRAIN_DELAY
+#define MESH_ONOFF_TRACE_DRAIN_DELAY                        500         // Trace records are formatted this many milliseconds after the first record is written
+#endif
+#define MESH_ONOFF_TRACE_DRAIN_EARLY_DELAY                  1           // Drain delay once the ring buffer is half full
+
+#if (MESH_ONOFF_TRACE_RING_SIZE < 2) || (MESH_ONOFF_TRACE_RING_SIZE > 0x8000) || (MESH_ONOFF_TRACE_RING_SIZE & (MESH_ONOFF_TRACE_RING_SIZE - 1))
+#error "MESH_ONOFF_TRACE_RING_SIZE shall be a power of 2 from 2 to 32768"
+#endif
+#if (MESH_ONOFF_TRACE_DRAIN_DELAY < 1)
+#error "MESH_ONOFF_TRACE_DRAIN_DELAY shall be at least 1 millisecond"
+#endif
+#endif
+
+#if defined(ONOFF_STATS_SUPPORTED) && !defined(HCI_CONTROL)
+#undef ONOFF_STATS_SUPPORTED            // statistics are only reported to the host over WICED HCI
+#endif
+
+#if defined(ONOFF_SCENES_SUPPORTED) && !defined(HCI_CONTROL)
+#undef ONOFF_SCENES_SUPPORTED           // scenes are only stored and recalled over WICED HCI
+#endif
+
+// Hot path counters and latency histograms
+#ifdef ONOFF_STATS_SUPPORTED
+#define MESH_ONOFF_STATS_BUCKETS                            16          // Bucket i counts latencies from 2^i to 2^(i+1)-1 microseconds, the last bucket counts all longer latencies
+#define MESH_ONOFF_STATS_INC(counter)                       mesh_onoff_stats.counter++
+#define MESH_ONOFF_STATS_START(timestamp)                   timestamp = clock_SystemTimeMicroseconds64()
+#define MESH_ONOFF_STATS_LATENCY(histogram, timestamp)      mesh_onoff_stats_add_latency(mesh_onoff_stats.histogram, timestamp)
+#else
+#define MESH_ONOFF_STATS_INC(counter)
+#define MESH_ONOFF_STATS_START(timestamp)
+#define MESH_ONOFF_STATS_LATENCY(histogram, timestamp)
+#endif
+
+// Boot phases, index into mesh_onoff_boot_time[]
+#define MESH_ONOFF_BOOT_PHASE_INIT_START                    0           // mesh_app_init called
+#define MESH_ONOFF_BOOT_PHASE_INIT_DONE                     1           // all models initialized, mesh_app_init returns
+#define MESH_ONOFF_BOOT_PHASE_FIRST_COMMAND                 2           // first WICED HCI command received
+#define MESH_ONOFF_BOOT_PHASE_FIRST_STATUS                  3           // first OnOff status received from the OnOff Server model
+#define MESH_ONOFF_BOOT_PHASES                              4
+
+#ifdef ONOFF_STATS_SUPPORTED
+#define MESH_ONOFF_BOOT_TIME(phase)                         do { if (mesh_onoff_boot_time[phase] == 0) mesh_onoff_boot_time[phase] = clock_SystemTimeMicroseconds64(); } while (0)
+#else
+#define MESH_ONOFF_BOOT_TIME(phase)
+#endif
+
+// Sizes of the dispatch tables filled in the mesh_app_init
+#define MESH_APP_HCI_CMD_HANDLERS_MAX                       16          // Max number of WICED HCI commands handled by the application
+#define MESH_APP_MODEL_EVENT_HANDLERS_MAX                   8           // Max number of (model, event) pairs handled by the application
+
+// Identifiers of the hot path traces, index into mesh_onoff_trace_fmt[]
+#define MESH_ONOFF_TRACE_ID_STATUS                          0
+#define MESH_ONOFF_TRACE_ID_RX_CMD                          1
+#define MESH_ONOFF_TRACE_ID_UNKNOWN_EVENT                   2
+#define MESH_ONOFF_TRACE_ID_UNKNOWN_CMD                     3
+
+// Hot path traces. With ONOFF_DEFERRED_TRACE_SUPPORTED only a binary record is saved and formatted later.
+#if !defined(WICED_BT_TRACE_ENABLE)
+#define MESH_ONOFF_TRACE(id, arg0, arg1, arg2)
+#elif defined(ONOFF_DEFERRED_TRACE_SUPPORTED)
+#define MESH_ONOFF_TRACE(id, arg0, arg1, arg2)  mesh_onoff_trace_put(id, (uint16_t)(arg0), (uint32_t)(arg1), (uint32_t)(arg2))
+#else
+#define MESH_ONOFF_TRACE(id, arg0, arg1, arg2)  WICED_BT_TRACE(mesh_onoff_trace_fmt[id], arg0, arg1, arg2)
+#endif
+
+#if (NUM_ONOFF_SERVERS < 1) || (NUM_ONOFF_SERVERS > 64)
+#error "NUM_ONOFF_SERVERS shall be from 1 to 64"
+#endif
+#if defined(LARGE_COMPOSITION_DATA_SUPPORTED) && (NUM_ONOFF_SERVERS > 1)
+#error "LARGE_COMPOSITION_DATA_SUPPORTED: the 9 Light XYL elements fill the node up to 10 elements, NUM_ONOFF_SERVERS shall be 1"
+#endif
+
+// Access to the per element bits of the packed state arrays
+#define MESH_ONOFF_BITSET_LEN           ((NUM_ONOFF_SERVERS + 7) / 8)
+#define MESH_ONOFF_BIT_GET(a, idx)      (((a)[(idx) >> 3] >> ((idx) & 7)) & 1)
+#define MESH_ONOFF_BIT_SET(a, idx)      ((a)[(idx) >> 3] |= (uint8_t)(1 << ((idx) & 7)))
+#define MESH_ONOFF_BIT_CLEAR(a, idx)    ((a)[(idx) >> 3] &= (uint8_t)~(1 << ((idx) & 7)))
 
 /******************************************************
  *          Structures
  ******************************************************/
+// Handler of a WICED HCI command, p_data points to the command payload. Returns WICED_FALSE if the command is not handled.
+typedef uint32_t (*mesh_app_hci_cmd_handler_t)(uint8_t *p_data, uint32_t length);
+// Handler of an event received from a server model
+typedef void (*mesh_app_model_event_handler_t)(uint8_t element_idx, void *p_data);
+
+// Entry of a dispatch table. Entries are sorted by the key: HCI opcode, or model ID and event.
+typedef struct
+{
+    uint32_t key;
+    void     (*p_handler)(void);
+} mesh_app_dispatch_entry_t;
+
+typedef struct
+{
+    uint8_t                     num_entries;
+    uint8_t                     max_entries;
+    mesh_app_dispatch_entry_t   *p_entries;
+} mesh_app_dispatch_table_t;
+
 typedef struct
 {
-    uint8_t  present_state;
-    uint8_t  target_state;
+    uint8_t  present_state[MESH_ONOFF_BITSET_LEN];      // present OnOff state, one bit per element
+    uint8_t  target_state[MESH_ONOFF_BITSET_LEN];       // target OnOff state, one bit per element
+    uint8_t  remaining_time[NUM_ONOFF_SERVERS];         // remaining transition time of each element in the Generic Transition Time format, 100 ms to 10 min steps
 } mesh_onoff_server_t;
 
+#ifdef ONOFF_STATS_SUPPORTED
+// Sent to the host as is, all members shall be uint32_t
+typedef struct
+{
+    uint32_t cmd_onoff_set;                             // number of HCI_CONTROL_MESH_COMMAND_ONOFF_SET received
+    uint32_t cmd_onoff_set_multi;                       // number of HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI received
+    uint32_t cmd_report_policy_set;                     // number of HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET received
+    uint32_t cmd_stats_get;                             // number of HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET received
+    uint32_t cmd_scene_store;                           // number of HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE received
+    uint32_t cmd_scene_recall;                          // number of HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL received
+    uint32_t cmd_scene_delete;                          // number of HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE received
+    uint32_t cmd_unknown;                               // number of commands with unknown opcode
+    uint32_t event_status;                              // number of WICED_BT_MESH_ONOFF_STATUS received from the OnOff Server model
+    uint32_t event_unknown;                             // number of unknown events received from the OnOff Server model
+    uint32_t hci_alloc_fail;                            // number of HCI events not sent because no buffer was available
+    uint32_t status_queued;                             // number of status events delayed because no buffer was available
+    uint32_t status_overwritten;                        // number of delayed status events replaced by a newer status of the same element
+    uint32_t status_dropped;                            // number of status events lost because the queue was full
+    uint32_t log_changes;                               // number of target state changes to be saved in NVRAM
+    uint32_t log_writes;                                // number of records written to NVRAM
+    uint32_t vendor_status_changes;                     // number of element state changes to be published with the vendor model
+    uint32_t vendor_status_published;                   // number of vendor model multi element status messages published
+    uint32_t vendor_status_send_fail;                   // number of vendor model messages the mesh core failed to send, their changes are published again
+    uint32_t vendor_status_no_publication;              // number of vendor model messages not sent because publication is not configured
+    uint32_t cmd_latency[MESH_ONOFF_STATS_BUCKETS];     // latency from command receipt to the state change passed to the OnOff Server model
+    uint32_t status_latency[MESH_ONOFF_STATS_BUCKETS];  // latency from status notification to the status passed to the transport
+} mesh_onoff_stats_t;
+#endif
+
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+// Record of the OnOff state log in NVRAM
+typedef struct
+{
+    uint32_t sequence;                                  // incremented for each record, the record with highest sequence is the newest
+    uint8_t  target_state[MESH_ONOFF_BITSET_LEN];       // target OnOff state, one bit per element
+} mesh_onoff_log_record_t;
+#endif
+
+#ifdef ONOFF_SCENES_SUPPORTED
+// OnOff scene. Bit i of the masks refers to the element i.
+typedef struct
+{
+    uint8_t  select[MESH_ONOFF_BITSET_LEN];             // elements which state is set by the scene
+    uint8_t  onoff[MESH_ONOFF_BITSET_LEN];              // OnOff state of the selected elements
+} mesh_onoff_scene_t;
+#endif
+
+#ifdef ONOFF_DEFERRED_TRACE_SUPPORTED
+typedef struct
+{
+    uint16_t id;                                        // trace identifier, MESH_ONOFF_TRACE_ID_XXX
+    uint16_t arg0;
+    uint32_t arg1;
+    uint32_t arg2;
+} mesh_onoff_trace_record_t;
+#endif
+
 /******************************************************
  *          Function Prototypes
  ******************************************************/
 static void mesh_app_init(wiced_bool_t is_provisioned);
 static uint32_t mesh_app_proc_rx_cmd(uint16_t opcode, uint8_t *p_data, uint32_t length);
 static void mesh_onoff_server_message_handler(uint8_t element_idx, uint16_t event, void *p_data);
+static wiced_bool_t mesh_app_dispatch_register(mesh_app_dispatch_table_t *p_table, uint32_t key, void (*p_handler)(void));
+static void (*mesh_app_dispatch_find(mesh_app_dispatch_table_t *p_table, uint32_t key))(void);
+#ifdef HCI_CONTROL
+static wiced_bool_t mesh_app_hci_cmd_register(uint16_t opcode, mesh_app_hci_cmd_handler_t p_handler);
+#endif
+static wiced_bool_t mesh_app_model_event_register(uint16_t model_id, uint16_t event, mesh_app_model_event_handler_t p_handler);
+static void mesh_app_model_event_dispatch(uint16_t model_id, uint8_t element_idx, uint16_t event, void *p_data);
+static void mesh_onoff_server_status_event(uint8_t element_idx, void *p_data);
+#if defined(HCI_CONTROL) || defined(ONOFF_SCENES_SUPPORTED) || defined(ONOFF_WRITE_BEHIND_SUPPORTED)
 static void mesh_onoff_server_send_state_change(uint8_t element_idx, uint8_t onoff);
+#endif
+#if defined(HCI_CONTROL) || defined(ONOFF_SCENES_SUPPORTED)
+static uint8_t mesh_onoff_server_send_state_change_multi(uint8_t element_idx, uint8_t *p_select, uint8_t *p_onoff, uint8_t mask_len);
+#endif
 static void mesh_onoff_server_process_status(uint8_t element_idx, wiced_bt_mesh_onoff_status_data_t *p_data);
+static wiced_bool_t mesh_onoff_server_report_needed(uint8_t element_idx, wiced_bool_t state_changed, wiced_bool_t target_changed, uint32_t remaining_time);
+static uint8_t mesh_onoff_transition_time_encode(uint32_t time_ms);
+#ifdef HCI_CONTROL
+static uint32_t mesh_onoff_transition_time_decode(uint8_t transition_time);
+#endif
 
 #ifdef HCI_CONTROL
+static void mesh_onoff_server_set_report_policy(uint8_t element_idx, uint8_t num_elements, uint8_t policy);
+static void mesh_onoff_hci_event_send_set_multi_status(uint8_t element_idx, uint8_t num_changed);
+static uint32_t mesh_onoff_hci_cmd_onoff_set(uint8_t *p_data, uint32_t length);
+static uint32_t mesh_onoff_hci_cmd_onoff_set_multi(uint8_t *p_data, uint32_t length);
+static uint32_t mesh_onoff_hci_cmd_report_policy_set(uint8_t *p_data, uint32_t length);
+#ifdef ONOFF_STATS_SUPPORTED
+static uint32_t mesh_onoff_hci_cmd_stats_get(uint8_t *p_data, uint32_t length);
+#endif
+#ifdef ONOFF_SCENES_SUPPORTED
+static uint32_t mesh_onoff_hci_cmd_scene_store(uint8_t *p_data, uint32_t length);
+static uint32_t mesh_onoff_hci_cmd_scene_recall(uint8_t *p_data, uint32_t length);
+static uint32_t mesh_onoff_hci_cmd_scene_delete(uint8_t *p_data, uint32_t length);
+static void mesh_onoff_hci_event_send_scene_status(uint8_t element_idx, uint8_t scene_idx, wiced_bool_t success, uint8_t num_changed);
+#endif
+#ifndef ONOFF_STATUS_BATCH_SUPPORTED
 static void mesh_onoff_hci_event_send_status(uint8_t element_idx, wiced_bt_mesh_onoff_status_data_t* p_data);
+static wiced_bool_t mesh_onoff_hci_event_try_send_status(uint8_t element_idx, uint8_t present_onoff, uint8_t target_onoff, uint32_t remaining_time);
+static void mesh_onoff_status_queue_put(uint8_t element_idx);
+static void mesh_onoff_status_queue_send(void);
+static void mesh_onoff_status_retry_timer_cb(TIMER_PARAM_TYPE arg);
+#endif
+#endif
+#ifdef ONOFF_SCENES_SUPPORTED
+static void mesh_onoff_scenes_restore(void);
+static wiced_bool_t mesh_onoff_scene_store(uint8_t scene_idx, uint8_t *p_select, uint8_t *p_onoff, uint8_t mask_len);
+static wiced_bool_t mesh_onoff_scene_recall(uint8_t scene_idx, uint8_t *p_num_changed);
+static wiced_bool_t mesh_onoff_scene_delete(uint8_t scene_idx);
+static void mesh_onoff_scenes_factory_reset(void);
+#endif
+#if defined(ONOFF_WRITE_BEHIND_SUPPORTED) || defined(ONOFF_SCENES_SUPPORTED)
+static void mesh_app_factory_reset(void);
+#endif
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+static void mesh_onoff_log_restore(void);
+static void mesh_onoff_log_flush(void);
+static void mesh_onoff_log_timer_cb(TIMER_PARAM_TYPE arg);
+static void mesh_onoff_log_factory_reset(void);
+#endif
+#ifdef ONOFF_STATS_SUPPORTED
+static void mesh_onoff_stats_add_latency(uint32_t *p_histogram, uint64_t start_time);
+static void mesh_onoff_hci_event_send_stats(uint8_t element_idx);
+#endif
+#ifdef ONOFF_DEFERRED_TRACE_SUPPORTED
+static void mesh_onoff_trace_put(uint16_t id, uint16_t arg0, uint32_t arg1, uint32_t arg2);
+static void mesh_onoff_trace_drain(void);
+static void mesh_onoff_trace_timer_cb(TIMER_PARAM_TYPE arg);
+#endif
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+static void mesh_onoff_batch_add_status(uint8_t element_idx);
+static void mesh_onoff_batch_flush(void);
+static void mesh_onoff_batch_timer_cb(TIMER_PARAM_TYPE arg);
+#endif
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+static void mesh_onoff_vendor_status_add(uint8_t element_idx);
+static void mesh_onoff_vendor_status_publish(void);
+static void mesh_onoff_vendor_status_timer_cb(TIMER_PARAM_TYPE arg);
 #endif
 
 /******************************************************
@@ -143,27 +595,44 @@ wiced_bt_mesh_core_config_model_t   mesh_element1_models[] =
     WICED_BT_MESH_MODEL_FW_DISTRIBUTOR_UPDATE_SERVER,
 #endif
     WICED_BT_MESH_MODEL_ONOFF_SERVER,
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+    { MESH_ONOFF_VENDOR_COMPANY_ID, MESH_ONOFF_VENDOR_MODEL_ID, NULL, NULL, NULL },
+#endif
 #ifdef MESH_VENDOR_TST_MODEL_ID
     { MESH_VENDOR_TST_COMPANY_ID, MESH_VENDOR_TST_MODEL_ID, NULL, NULL, NULL },
 #endif
 };
 #if NUM_ONOFF_SERVERS > 1
-wiced_bt_mesh_core_config_model_t   mesh_element2_models[] =
-{
-    WICED_BT_MESH_MODEL_ONOFF_SERVER,
-};
-#endif
-#if NUM_ONOFF_SERVERS > 2
-wiced_bt_mesh_core_config_model_t   mesh_element3_models[] =
-{
-    WICED_BT_MESH_MODEL_ONOFF_SERVER,
-};
-#endif
-#if NUM_ONOFF_SERVERS > 3
-wiced_bt_mesh_core_config_model_t   mesh_element4_models[] =
+// Models of the elements 2 to NUM_ONOFF_SERVERS. The array is shared by all those elements.
+wiced_bt_mesh_core_config_model_t   mesh_onoff_element_models[] =
 {
     WICED_BT_MESH_MODEL_ONOFF_SERVER,
 };
+
+#define MESH_ONOFF_ELEMENT \
+    {                                                                   \
+        .location = MESH_ELEM_LOC_MAIN,                                 \
+        .default_transition_time = MESH_DEFAULT_TRANSITION_TIME_IN_MS,  \
+        .onpowerup_state = MESH_ONOFF_ONPOWERUP_STATE,                  \
+        .default_level = 0,                                             \
+        .range_min = 1,                                                 \
+        .range_max = 0xffff,                                            \
+        .move_rollover = 0,                                             \
+        .properties_num = 0,                                            \
+        .properties = NULL,                                             \
+        .sensors_num = 0,                                               \
+        .sensors = NULL,                                                \
+        .models_num = (sizeof(mesh_onoff_element_models) / sizeof(wiced_bt_mesh_core_config_model_t)),  \
+        .models = mesh_onoff_element_models                             \
+    }
+
+// Expand to the given number of MESH_ONOFF_ELEMENT initializers
+#define MESH_ONOFF_ELEMENTS_X1      MESH_ONOFF_ELEMENT,
+#define MESH_ONOFF_ELEMENTS_X2      MESH_ONOFF_ELEMENTS_X1  MESH_ONOFF_ELEMENTS_X1
+#define MESH_ONOFF_ELEMENTS_X4      MESH_ONOFF_ELEMENTS_X2  MESH_ONOFF_ELEMENTS_X2
+#define MESH_ONOFF_ELEMENTS_X8      MESH_ONOFF_ELEMENTS_X4  MESH_ONOFF_ELEMENTS_X4
+#define MESH_ONOFF_ELEMENTS_X16     MESH_ONOFF_ELEMENTS_X8  MESH_ONOFF_ELEMENTS_X8
+#define MESH_ONOFF_ELEMENTS_X32     MESH_ONOFF_ELEMENTS_X16 MESH_ONOFF_ELEMENTS_X16
 #endif
 
 #ifdef LARGE_COMPOSITION_DATA_SUPPORTED
@@ -189,6 +658,7 @@ wiced_bt_mesh_core_config_model_t   mesh_element_x_models[] =
         .models_num = (sizeof(mesh_element_x_models) / sizeof(wiced_bt_mesh_core_config_model_t)),  \
         .models = mesh_element_x_models                                 \
     }
+
 #endif
 
 #define MESH_ONOFF_SERVER_ELEMENT_INDEX   0
@@ -198,7 +668,7 @@ wiced_bt_mesh_core_config_element_t mesh_elements[] =
     {
         .location = MESH_ELEM_LOC_MAIN,                                 // location description as defined in the GATT Bluetooth Namespace Descriptors section of the Bluetooth SIG Assigned Numbers
         .default_transition_time = MESH_DEFAULT_TRANSITION_TIME_IN_MS,  // Default transition time for models of the element in milliseconds
-        .onpowerup_state = WICED_BT_MESH_ON_POWER_UP_STATE_RESTORE,     // Default element behavior on power up
+        .onpowerup_state = MESH_ONOFF_ONPOWERUP_STATE,                  // Default element behavior on power up
         .default_level = 0,                                             // Default value of the variable controlled on this element (for example power, lightness, temperature, hue...)
         .range_min = 1,                                                 // Minimum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
         .range_max = 0xffff,                                            // Maximum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
@@ -210,56 +680,24 @@ wiced_bt_mesh_core_config_element_t mesh_elements[] =
         .models_num = (sizeof(mesh_element1_models) / sizeof(wiced_bt_mesh_core_config_model_t)),    // Number of models in the array models
         .models = mesh_element1_models,                                 // Array of models located in that element. Model data is defined by structure wiced_bt_mesh_core_config_model_t
     },
-#if NUM_ONOFF_SERVERS > 1
-    {
-        .location = MESH_ELEM_LOC_MAIN,                                 // location description as defined in the GATT Bluetooth Namespace Descriptors section of the Bluetooth SIG Assigned Numbers
-        .default_transition_time = MESH_DEFAULT_TRANSITION_TIME_IN_MS,  // Default transition time for models of the element in milliseconds
-        .onpowerup_state = WICED_BT_MESH_ON_POWER_UP_STATE_RESTORE,     // Default element behavior on power up
-        .default_level = 0,                                             // Default value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .range_min = 1,                                                 // Minimum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .range_max = 0xffff,                                            // Maximum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .move_rollover = 0,                                             // If true when level gets to range_max during move operation, it switches to min, otherwise move stops.
-        .properties_num = 0,                                            // Number of properties in the array models
-        .properties = NULL,                                             // Array of properties in the element.
-        .sensors_num = 0,                                               // Number of sensors in the sensor array
-        .sensors = NULL,                                                // Array of sensors of that element
-        .models_num = (sizeof(mesh_element2_models) / sizeof(wiced_bt_mesh_core_config_model_t)),                              // Number of models in the array models
-        .models = mesh_element2_models,                                 // Array of models located in that element. Model data is defined by structure wiced_bt_mesh_core_config_model_t
-    },
+    // Elements 2 to NUM_ONOFF_SERVERS, the binary representation of (NUM_ONOFF_SERVERS - 1) selects the blocks to add
+#if (NUM_ONOFF_SERVERS - 1) & 0x01
+    MESH_ONOFF_ELEMENTS_X1
 #endif
-#if NUM_ONOFF_SERVERS > 2
-    {
-        .location = MESH_ELEM_LOC_MAIN,                                 // location description as defined in the GATT Bluetooth Namespace Descriptors section of the Bluetooth SIG Assigned Numbers
-        .default_transition_time = MESH_DEFAULT_TRANSITION_TIME_IN_MS,  // Default transition time for models of the element in milliseconds
-        .onpowerup_state = WICED_BT_MESH_ON_POWER_UP_STATE_RESTORE,     // Default element behavior on power up
-        .default_level = 0,                                             // Default value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .range_min = 1,                                                 // Minimum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .range_max = 0xffff,                                            // Maximum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .move_rollover = 0,                                             // If true when level gets to range_max during move operation, it switches to min, otherwise move stops.
-        .properties_num = 0,                                            // Number of properties in the array models
-        .properties = NULL,                                             // Array of properties in the element.
-        .sensors_num = 0,                                               // Number of sensors in the sensor array
-        .sensors = NULL,                                                // Array of sensors of that element
-        .models_num = (sizeof(mesh_element3_models) / sizeof(wiced_bt_mesh_core_config_model_t)),                              // Number of models in the array models
-        .models = mesh_element3_models,                                 // Array of models located in that element. Model data is defined by structure wiced_bt_mesh_core_config_model_t
-    },
+#if (NUM_ONOFF_SERVERS - 1) & 0x02
+    MESH_ONOFF_ELEMENTS_X2
 #endif
-#if NUM_ONOFF_SERVERS > 3
-    {
-        .location = MESH_ELEM_LOC_MAIN,                                 // location description as defined in the GATT Bluetooth Namespace Descriptors section of the Bluetooth SIG Assigned Numbers
-        .default_transition_time = MESH_DEFAULT_TRANSITION_TIME_IN_MS,  // Default transition time for models of the element in milliseconds
-        .onpowerup_state = WICED_BT_MESH_ON_POWER_UP_STATE_RESTORE,     // Default element behavior on power up
-        .default_level = 0,                                             // Default value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .range_min = 1,                                                 // Minimum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .range_max = 0xffff,                                            // Maximum value of the variable controlled on this element (for example power, lightness, temperature, hue...)
-        .move_rollover = 0,                                             // If true when level gets to range_max during move operation, it switches to min, otherwise move stops.
-        .properties_num = 0,                                            // Number of properties in the array models
-        .properties = NULL,                                             // Array of properties in the element.
-        .sensors_num = 0,                                               // Number of sensors in the sensor array
-        .sensors = NULL,                                                // Array of sensors of that element
-        .models_num = (sizeof(mesh_element4_models) / sizeof(wiced_bt_mesh_core_config_model_t)),                              // Number of models in the array models
-        .models = mesh_element4_models,                                 // Array of models located in that element. Model data is defined by structure wiced_bt_mesh_core_config_model_t
-    },
+#if (NUM_ONOFF_SERVERS - 1) & 0x04
+    MESH_ONOFF_ELEMENTS_X4
+#endif
+#if (NUM_ONOFF_SERVERS - 1) & 0x08
+    MESH_ONOFF_ELEMENTS_X8
+#endif
+#if (NUM_ONOFF_SERVERS - 1) & 0x10
+    MESH_ONOFF_ELEMENTS_X16
+#endif
+#if (NUM_ONOFF_SERVERS - 1) & 0x20
+    MESH_ONOFF_ELEMENTS_X32
 #endif
 #ifdef LARGE_COMPOSITION_DATA_SUPPORTED
     // Add enough elements to create a large composition data
@@ -294,16 +732,16 @@ wiced_bt_mesh_core_config_t  mesh_config =
         .rssi_factor           = 2,                                 // contribution of the RSSI measured by the Friend node used in Friend Offer Delay calculations.
         .receive_window_factor = 2,                                 // contribution of the supported Receive Window used in Friend Offer Delay calculations.
         .min_cache_size_log    = 3,                                 // minimum number of messages that the Friend node can store in its Friend Cache.
-        .receive_delay         = 100,                               // Receive delay in 1 ms units to be requested by the Low Power node.
-        .poll_timeout          = 200                                // Poll timeout in 100ms units to be requested by the Low Power node.
+        .receive_delay         = MESH_LPN_RECEIVE_DELAY,            // Receive delay in 1 ms units to be requested by the Low Power node.
+        .poll_timeout          = MESH_LPN_POLL_TIMEOUT              // Poll timeout in 100ms units to be requested by the Low Power node.
     },
 #else
     .features = WICED_BT_MESH_CORE_FEATURE_BIT_FRIEND | WICED_BT_MESH_CORE_FEATURE_BIT_RELAY | WICED_BT_MESH_CORE_FEATURE_BIT_GATT_PROXY_SERVER,   // Supports Friend, Relay and GATT Proxy
     .friend_cfg         =                                           // Configuration of the Friend Feature(Receive Window in Ms, messages cache)
     {
         .receive_window        = 20,
-        .cache_buf_len         = 300,                               // Length of the buffer for the cache
-        .max_lpn_num           = 4                                  // Max number of Low Power Nodes with established friendship. Must be > 0 if Friend feature is supported.
+        .cache_buf_len         = MESH_FRIEND_CACHE_BUF_LEN,         // Length of the buffer for the cache
+        .max_lpn_num           = MESH_FRIEND_MAX_LPN_NUM            // Max number of Low Power Nodes with established friendship. Must be > 0 if Friend feature is supported.
     },
     .low_power          =                                           // Configuration of the Low Power Feature
     {
@@ -331,17 +769,97 @@ wiced_bt_mesh_app_func_table_t wiced_bt_mesh_app_func_table =
     NULL,                   // notify period set
     mesh_app_proc_rx_cmd,   // WICED HCI command
     NULL,                   // LPN sleep
+#if defined(ONOFF_WRITE_BEHIND_SUPPORTED) || defined(ONOFF_SCENES_SUPPORTED)
+    mesh_app_factory_reset  // factory reset
+#else
     NULL                    // factory reset
+#endif
 };
 
 // Application state
 mesh_onoff_server_t app_state;
 
+// Dispatch tables of the WICED HCI commands and of the server model events
+mesh_app_dispatch_entry_t mesh_app_hci_cmd_entries[MESH_APP_HCI_CMD_HANDLERS_MAX];
+mesh_app_dispatch_table_t mesh_app_hci_cmd_table = { 0, MESH_APP_HCI_CMD_HANDLERS_MAX, mesh_app_hci_cmd_entries };
+mesh_app_dispatch_entry_t mesh_app_model_event_entries[MESH_APP_MODEL_EVENT_HANDLERS_MAX];
+mesh_app_dispatch_table_t mesh_app_model_event_table = { 0, MESH_APP_MODEL_EVENT_HANDLERS_MAX, mesh_app_model_event_entries };
+
+// Format strings of the hot path traces
+const char *mesh_onoff_trace_fmt[] =
+{
+    "onoff srv set onoff: present:%d target:%d remaining:%d\n",   // MESH_ONOFF_TRACE_ID_STATUS
+    "onoff rx cmd_opcode 0x%02x\n",                               // MESH_ONOFF_TRACE_ID_RX_CMD
+    "unknown event:%d\n",                                         // MESH_ONOFF_TRACE_ID_UNKNOWN_EVENT
+    "unknown cmd_opcode 0x%02x\n",                                // MESH_ONOFF_TRACE_ID_UNKNOWN_CMD
+};
+
+#ifdef ONOFF_SCENES_SUPPORTED
+mesh_onoff_scene_t  mesh_onoff_scenes[MESH_ONOFF_SCENES_MAX];
+uint16_t            mesh_onoff_scenes_valid;            // bit per scene, set if the scene is stored
+#endif
+
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+// Last record written to or restored from NVRAM
+mesh_onoff_log_record_t mesh_onoff_log;
+wiced_timer_t           mesh_onoff_log_timer;
+#endif
+
+#ifdef ONOFF_STATS_SUPPORTED
+mesh_onoff_stats_t  mesh_onoff_stats;
+uint64_t            mesh_onoff_stats_cmd_start;
+uint64_t            mesh_onoff_stats_status_start;
+// Time in microseconds since power up when each boot phase has been reached, 0 until then. 64 bit because a 32 bit value
+// wraps after about 71 minutes and could read as not reached. Not cleared by the stats reset.
+uint64_t            mesh_onoff_boot_time[MESH_ONOFF_BOOT_PHASES];
+#endif
+
+#ifdef ONOFF_DEFERRED_TRACE_SUPPORTED
+// Ring buffer of the trace records. Written only by mesh_onoff_trace_put() at the head and read only by mesh_onoff_trace_drain() at the tail.
+mesh_onoff_trace_record_t   mesh_onoff_trace_ring[MESH_ONOFF_TRACE_RING_SIZE];
+volatile uint16_t           mesh_onoff_trace_head;
+volatile uint16_t           mesh_onoff_trace_tail;
+uint16_t                    mesh_onoff_trace_lost;
+wiced_timer_t               mesh_onoff_trace_timer;
+#endif
+
+// Status report policy of each element, 2 bits per element
+uint8_t mesh_onoff_report_policy[(NUM_ONOFF_SERVERS + 3) / 4];
+// Number of status notifications to skip before the next report with the MESH_ONOFF_REPORT_POLICY_ADAPTIVE
+uint8_t mesh_onoff_report_skip[NUM_ONOFF_SERVERS];
+
+#if defined(HCI_CONTROL) && !defined(ONOFF_STATUS_BATCH_SUPPORTED)
+// FIFO of elements which status could not be sent because the transport was out of buffers. An element is queued only once,
+// its latest status is taken from the app_state when the event is sent.
+uint8_t         mesh_onoff_status_queue[MESH_ONOFF_STATUS_QUEUE_SIZE];
+uint8_t         mesh_onoff_status_queue_head;
+uint8_t         mesh_onoff_status_queue_count;
+uint8_t         mesh_onoff_status_queued[MESH_ONOFF_BITSET_LEN];
+wiced_timer_t   mesh_onoff_status_retry_timer;
+#endif
+
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+// Elements which status shall be sent to the host with the next batch. The latest status is taken from the app_state.
+uint8_t         mesh_onoff_batch_pending[MESH_ONOFF_BITSET_LEN];
+uint8_t         mesh_onoff_batch_num_pending;
+wiced_timer_t   mesh_onoff_batch_timer;
+#endif
+
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+// Elements which state shall be published with the next vendor model message. The latest state is taken from the app_state.
+uint8_t         mesh_onoff_vendor_status_pending[MESH_ONOFF_BITSET_LEN];
+wiced_timer_t   mesh_onoff_vendor_status_timer;
+#endif
+
 /******************************************************
  *               Function Definitions
  ******************************************************/
 void mesh_app_init(wiced_bool_t is_provisioned)
 {
+    uint8_t element_idx;
+
+    MESH_ONOFF_BOOT_TIME(MESH_ONOFF_BOOT_PHASE_INIT_START);
+
 #if 0
     // Set Debug trace level for mesh_models_lib and mesh_provisioner_lib
     wiced_bt_mesh_models_set_trace_level(WICED_BT_MESH_CORE_TRACE_INFO);
@@ -395,6 +913,58 @@ void mesh_app_init(wiced_bool_t is_provisioned)
 
     memset (&app_state, 0, sizeof(app_state));
 
+    // Fill dispatch tables before the models can deliver events
+    mesh_app_hci_cmd_table.num_entries = 0;
+    mesh_app_model_event_table.num_entries = 0;
+    mesh_app_model_event_register(WICED_BT_MESH_CORE_MODEL_ID_GENERIC_ONOFF_SRV, WICED_BT_MESH_ONOFF_STATUS, mesh_onoff_server_status_event);
+#ifdef HCI_CONTROL
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_SET, mesh_onoff_hci_cmd_onoff_set);
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI, mesh_onoff_hci_cmd_onoff_set_multi);
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET, mesh_onoff_hci_cmd_report_policy_set);
+#ifdef ONOFF_STATS_SUPPORTED
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET, mesh_onoff_hci_cmd_stats_get);
+#endif
+#ifdef ONOFF_SCENES_SUPPORTED
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE, mesh_onoff_hci_cmd_scene_store);
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL, mesh_onoff_hci_cmd_scene_recall);
+    mesh_app_hci_cmd_register(HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE, mesh_onoff_hci_cmd_scene_delete);
+#endif
+#endif
+
+#ifdef ONOFF_SCENES_SUPPORTED
+    mesh_onoff_scenes_restore();
+#endif
+    memset(mesh_onoff_report_policy, MESH_ONOFF_REPORT_POLICY_DEFAULT * 0x55, sizeof(mesh_onoff_report_policy));
+    memset(mesh_onoff_report_skip, 0, sizeof(mesh_onoff_report_skip));
+
+#ifdef ONOFF_STATS_SUPPORTED
+    memset(&mesh_onoff_stats, 0, sizeof(mesh_onoff_stats));
+#endif
+
+#ifdef ONOFF_DEFERRED_TRACE_SUPPORTED
+    mesh_onoff_trace_head = mesh_onoff_trace_tail = 0;
+    mesh_onoff_trace_lost = 0;
+    wiced_init_timer(&mesh_onoff_trace_timer, &mesh_onoff_trace_timer_cb, 0, WICED_MILLI_SECONDS_TIMER);
+#endif
+
+#if defined(HCI_CONTROL) && !defined(ONOFF_STATUS_BATCH_SUPPORTED)
+    mesh_onoff_status_queue_head = 0;
+    mesh_onoff_status_queue_count = 0;
+    memset(mesh_onoff_status_queued, 0, sizeof(mesh_onoff_status_queued));
+    wiced_init_timer(&mesh_onoff_status_retry_timer, &mesh_onoff_status_retry_timer_cb, 0, WICED_MILLI_SECONDS_TIMER);
+#endif
+
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+    memset(mesh_onoff_batch_pending, 0, sizeof(mesh_onoff_batch_pending));
+    mesh_onoff_batch_num_pending = 0;
+    wiced_init_timer(&mesh_onoff_batch_timer, &mesh_onoff_batch_timer_cb, 0, WICED_MILLI_SECONDS_TIMER);
+#endif
+
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+    memset(mesh_onoff_vendor_status_pending, 0, sizeof(mesh_onoff_vendor_status_pending));
+    wiced_init_timer(&mesh_onoff_vendor_status_timer, &mesh_onoff_vendor_status_timer_cb, 0, WICED_MILLI_SECONDS_TIMER);
+#endif
+
 #if REMOTE_PROVISION_SERVER_SUPPORTED
     wiced_bt_mesh_remote_provisioning_server_init();
 #endif
@@ -405,15 +975,15 @@ void mesh_app_init(wiced_bool_t is_provisioned)
     wiced_bt_mesh_model_fw_distribution_server_init();
 #endif
 
-#if NUM_ONOFF_SERVERS > 1
-    wiced_bt_mesh_model_onoff_server_init(1, mesh_onoff_server_message_handler, TRANSITION_INTERVAL, is_provisioned);
-#endif
-#if NUM_ONOFF_SERVERS > 2
-    wiced_bt_mesh_model_onoff_server_init(2, mesh_onoff_server_message_handler, TRANSITION_INTERVAL, is_provisioned);
-#endif
-#if NUM_ONOFF_SERVERS > 3
-    wiced_bt_mesh_model_onoff_server_init(3, mesh_onoff_server_message_handler, TRANSITION_INTERVAL, is_provisioned);
+    for (element_idx = MESH_ONOFF_SERVER_ELEMENT_INDEX + 1; element_idx < NUM_ONOFF_SERVERS; element_idx++)
+        wiced_bt_mesh_model_onoff_server_init(element_idx, mesh_onoff_server_message_handler, TRANSITION_INTERVAL, is_provisioned);
+
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+    wiced_init_timer(&mesh_onoff_log_timer, &mesh_onoff_log_timer_cb, 0, WICED_MILLI_SECONDS_TIMER);
+    if (is_provisioned)
+        mesh_onoff_log_restore();
 #endif
+    MESH_ONOFF_BOOT_TIME(MESH_ONOFF_BOOT_PHASE_INIT_DONE);
 }
 
 /*
@@ -421,15 +991,18 @@ void mesh_app_init(wiced_bool_t is_provisioned)
  */
 void mesh_onoff_server_message_handler(uint8_t element_idx, uint16_t event, void *p_data)
 {
-    switch (event)
-    {
-    case WICED_BT_MESH_ONOFF_STATUS:
-        mesh_onoff_server_process_status(element_idx, (wiced_bt_mesh_onoff_status_data_t *)p_data);
-        break;
+    mesh_app_model_event_dispatch(WICED_BT_MESH_CORE_MODEL_ID_GENERIC_ONOFF_SRV, element_idx, event, p_data);
+}
 
-    default:
-        WICED_BT_TRACE("unknown\n");
-    }
+/*
+ * Process OnOff Status event received from the OnOff Server model
+ */
+void mesh_onoff_server_status_event(uint8_t element_idx, void *p_data)
+{
+    MESH_ONOFF_STATS_START(mesh_onoff_stats_status_start);
+    MESH_ONOFF_STATS_INC(event_status);
+    MESH_ONOFF_BOOT_TIME(MESH_ONOFF_BOOT_PHASE_FIRST_STATUS);
+    mesh_onoff_server_process_status(element_idx, (wiced_bt_mesh_onoff_status_data_t *)p_data);
 }
 
 /*
@@ -437,36 +1010,359 @@ void mesh_onoff_server_message_handler(uint8_t element_idx, uint16_t event, void
  */
 uint32_t mesh_app_proc_rx_cmd(uint16_t opcode, uint8_t *p_data, uint32_t length)
 {
-    uint8_t element_idx;
+    mesh_app_hci_cmd_handler_t p_handler;
 
-    WICED_BT_TRACE("onoff rx cmd_opcode 0x%02x\n", opcode);
+    MESH_ONOFF_STATS_START(mesh_onoff_stats_cmd_start);
+    MESH_ONOFF_BOOT_TIME(MESH_ONOFF_BOOT_PHASE_FIRST_COMMAND);
+    MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_RX_CMD, opcode, 0, 0);
 
-    switch (opcode)
+    p_handler = (mesh_app_hci_cmd_handler_t)mesh_app_dispatch_find(&mesh_app_hci_cmd_table, opcode);
+    if (p_handler == NULL)
     {
+        MESH_ONOFF_STATS_INC(cmd_unknown);
+        MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_UNKNOWN_CMD, opcode, 0, 0);
+        return WICED_FALSE;
+    }
+    return p_handler(p_data, length);
+}
+
+/*
+ * Insert handler into the dispatch table keeping the entries sorted by the key
+ */
+wiced_bool_t mesh_app_dispatch_register(mesh_app_dispatch_table_t *p_table, uint32_t key, void (*p_handler)(void))
+{
+    uint8_t i;
+
+    if (p_table->num_entries >= p_table->max_entries)
+    {
+        WICED_BT_TRACE("dispatch table full key:%x\n", key);
+        return WICED_FALSE;
+    }
+    for (i = p_table->num_entries; (i > 0) && (p_table->p_entries[i - 1].key > key); i--)
+        p_table->p_entries[i] = p_table->p_entries[i - 1];
+
+    p_table->p_entries[i].key       = key;
+    p_table->p_entries[i].p_handler = p_handler;
+    p_table->num_entries++;
+    return WICED_TRUE;
+}
+
+/*
+ * Binary search of the handler registered for the key. Returns NULL if there is none.
+ */
+void (*mesh_app_dispatch_find(mesh_app_dispatch_table_t *p_table, uint32_t key))(void)
+{
+    uint8_t low = 0, high = p_table->num_entries, mid;
+
+    while (low < high)
+    {
+        mid = (uint8_t)((low + high) / 2);
+        if (p_table->p_entries[mid].key == key)
+            return p_table->p_entries[mid].p_handler;
+        if (p_table->p_entries[mid].key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return NULL;
+}
+
 #ifdef HCI_CONTROL
-    case HCI_CONTROL_MESH_COMMAND_ONOFF_SET:
-        element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
-        mesh_onoff_server_send_state_change(element_idx, *p_data);
-        break;
+/*
+ * Register handler of a WICED HCI command
+ */
+wiced_bool_t mesh_app_hci_cmd_register(uint16_t opcode, mesh_app_hci_cmd_handler_t p_handler)
+{
+    return mesh_app_dispatch_register(&mesh_app_hci_cmd_table, opcode, (void (*)(void))p_handler);
+}
 #endif
-    default:
-        WICED_BT_TRACE("unknown\n");
-        return WICED_FALSE;
+
+/*
+ * Register handler of an event received from a server model
+ */
+wiced_bool_t mesh_app_model_event_register(uint16_t model_id, uint16_t event, mesh_app_model_event_handler_t p_handler)
+{
+    return mesh_app_dispatch_register(&mesh_app_model_event_table, ((uint32_t)model_id << 16) | event, (void (*)(void))p_handler);
+}
+
+/*
+ * Call the handler registered for the event received from a server model
+ */
+void mesh_app_model_event_dispatch(uint16_t model_id, uint8_t element_idx, uint16_t event, void *p_data)
+{
+    mesh_app_model_event_handler_t p_handler;
+
+    p_handler = (mesh_app_model_event_handler_t)mesh_app_dispatch_find(&mesh_app_model_event_table, ((uint32_t)model_id << 16) | event);
+    if (p_handler == NULL)
+    {
+        MESH_ONOFF_STATS_INC(event_unknown);
+        MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_UNKNOWN_EVENT, event, 0, 0);
+        return;
     }
+    p_handler(element_idx, p_data);
+}
+
+#ifdef HCI_CONTROL
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_SET
+ */
+uint32_t mesh_onoff_hci_cmd_onoff_set(uint8_t *p_data, uint32_t length)
+{
+    uint8_t element_idx;
+
+    MESH_ONOFF_STATS_INC(cmd_onoff_set);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    mesh_onoff_server_send_state_change(element_idx, *p_data);
+    MESH_ONOFF_STATS_LATENCY(cmd_latency, mesh_onoff_stats_cmd_start);
+    return WICED_TRUE;
+}
+
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI
+ */
+uint32_t mesh_onoff_hci_cmd_onoff_set_multi(uint8_t *p_data, uint32_t length)
+{
+    uint8_t element_idx;
+    uint8_t num_changed;
+
+    MESH_ONOFF_STATS_INC(cmd_onoff_set_multi);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    if ((length < 2) || ((length & 1) != 0))
+        return WICED_FALSE;
+    num_changed = mesh_onoff_server_send_state_change_multi(element_idx, p_data, p_data + length / 2, (uint8_t)(length / 2));
+    MESH_ONOFF_STATS_LATENCY(cmd_latency, mesh_onoff_stats_cmd_start);
+    mesh_onoff_hci_event_send_set_multi_status(element_idx, num_changed);
+    return WICED_TRUE;
+}
+
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_REPORT_POLICY_SET
+ */
+uint32_t mesh_onoff_hci_cmd_report_policy_set(uint8_t *p_data, uint32_t length)
+{
+    uint8_t element_idx;
+    uint8_t num_elements;
+
+    MESH_ONOFF_STATS_INC(cmd_report_policy_set);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    if ((length < 1) || (p_data[0] > MESH_ONOFF_REPORT_POLICY_ADAPTIVE))
+        return WICED_FALSE;
+    num_elements = (length >= 2) ? p_data[1] : 1;
+    mesh_onoff_server_set_report_policy(element_idx, num_elements, p_data[0]);
+    return WICED_TRUE;
+}
+
+#ifdef ONOFF_STATS_SUPPORTED
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_STATS_GET
+ */
+uint32_t mesh_onoff_hci_cmd_stats_get(uint8_t *p_data, uint32_t length)
+{
+    uint8_t element_idx;
+
+    MESH_ONOFF_STATS_INC(cmd_stats_get);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    mesh_onoff_hci_event_send_stats(element_idx);
+    if ((length >= 1) && (p_data[0] != 0))
+        memset(&mesh_onoff_stats, 0, sizeof(mesh_onoff_stats));
+    return WICED_TRUE;
+}
+#endif
+
+#ifdef ONOFF_SCENES_SUPPORTED
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_STORE
+ */
+uint32_t mesh_onoff_hci_cmd_scene_store(uint8_t *p_data, uint32_t length)
+{
+    uint8_t      element_idx;
+    uint8_t      mask_len;
+    wiced_bool_t success;
+
+    MESH_ONOFF_STATS_INC(cmd_scene_store);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    if ((length < 2) || (length != 2 + 2 * (uint32_t)p_data[1]))
+        return WICED_FALSE;
+
+    // Mask length 0 stores current target state of all elements
+    mask_len = p_data[1];
+    if (mask_len == 0)
+        success = mesh_onoff_scene_store(p_data[0], NULL, NULL, 0);
+    else
+        success = mesh_onoff_scene_store(p_data[0], &p_data[2], &p_data[2 + mask_len], mask_len);
+    mesh_onoff_hci_event_send_scene_status(element_idx, p_data[0], success, 0);
+    return WICED_TRUE;
+}
+
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_RECALL
+ */
+uint32_t mesh_onoff_hci_cmd_scene_recall(uint8_t *p_data, uint32_t length)
+{
+    uint8_t      element_idx;
+    uint8_t      num_changed = 0;
+    wiced_bool_t success;
+
+    MESH_ONOFF_STATS_INC(cmd_scene_recall);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    if (length < 1)
+        return WICED_FALSE;
+
+    success = mesh_onoff_scene_recall(p_data[0], &num_changed);
+    MESH_ONOFF_STATS_LATENCY(cmd_latency, mesh_onoff_stats_cmd_start);
+    mesh_onoff_hci_event_send_scene_status(element_idx, p_data[0], success, num_changed);
+    return WICED_TRUE;
+}
+
+/*
+ * Process HCI_CONTROL_MESH_COMMAND_ONOFF_SCENE_DELETE
+ */
+uint32_t mesh_onoff_hci_cmd_scene_delete(uint8_t *p_data, uint32_t length)
+{
+    uint8_t element_idx;
+
+    MESH_ONOFF_STATS_INC(cmd_scene_delete);
+    element_idx = wiced_bt_mesh_get_element_idx_from_wiced_hci(&p_data, &length);
+    if (length < 1)
+        return WICED_FALSE;
+
+    mesh_onoff_hci_event_send_scene_status(element_idx, p_data[0], mesh_onoff_scene_delete(p_data[0]), 0);
     return WICED_TRUE;
 }
+#endif
+#endif
 
 /*
  * This function is called when command to change state is received over mesh.
  */
 void mesh_onoff_server_process_status(uint8_t element_idx, wiced_bt_mesh_onoff_status_data_t *p_status)
 {
-    WICED_BT_TRACE("onoff srv set onoff: present:%d target:%d remaining:%d\n", p_status->present_onoff, p_status->target_onoff, p_status->remaining_time);
-#if defined HCI_CONTROL
+    wiced_bool_t state_changed, target_changed;
+
+    if (element_idx >= NUM_ONOFF_SERVERS)
+        return;
+
+    state_changed  = (MESH_ONOFF_BIT_GET(app_state.present_state, element_idx) != (p_status->present_onoff & 1));
+    target_changed = (MESH_ONOFF_BIT_GET(app_state.target_state, element_idx) != (p_status->target_onoff & 1));
+
+    if (p_status->present_onoff)
+        MESH_ONOFF_BIT_SET(app_state.present_state, element_idx);
+    else
+        MESH_ONOFF_BIT_CLEAR(app_state.present_state, element_idx);
+    if (p_status->target_onoff)
+        MESH_ONOFF_BIT_SET(app_state.target_state, element_idx);
+    else
+        MESH_ONOFF_BIT_CLEAR(app_state.target_state, element_idx);
+    app_state.remaining_time[element_idx] = mesh_onoff_transition_time_encode(p_status->remaining_time);
+
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+    if (target_changed)
+    {
+        MESH_ONOFF_STATS_INC(log_changes);
+        if (!wiced_is_timer_in_use(&mesh_onoff_log_timer))
+            wiced_start_timer(&mesh_onoff_log_timer, MESH_ONOFF_LOG_FLUSH_DELAY);
+    }
+#endif
+
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+    if (state_changed || target_changed)
+        mesh_onoff_vendor_status_add(element_idx);
+#endif
+
+    if (!mesh_onoff_server_report_needed(element_idx, state_changed || target_changed, target_changed, p_status->remaining_time))
+        return;
+
+    MESH_ONOFF_TRACE(MESH_ONOFF_TRACE_ID_STATUS, p_status->present_onoff, p_status->target_onoff, p_status->remaining_time);
+
+#if defined ONOFF_STATUS_BATCH_SUPPORTED
+    mesh_onoff_batch_add_status(element_idx);
+#elif defined HCI_CONTROL
     mesh_onoff_hci_event_send_status(element_idx, p_status);
 #endif
+    MESH_ONOFF_STATS_LATENCY(status_latency, mesh_onoff_stats_status_start);
+}
+
+/*
+ * Check if the status of the element shall be reported according to the element report policy
+ */
+wiced_bool_t mesh_onoff_server_report_needed(uint8_t element_idx, wiced_bool_t state_changed, wiced_bool_t target_changed, uint32_t remaining_time)
+{
+    uint32_t num_intervals;
+
+    switch ((mesh_onoff_report_policy[element_idx / 4] >> ((element_idx % 4) * 2)) & 0x03)
+    {
+    case MESH_ONOFF_REPORT_POLICY_ON_CHANGE:
+        return state_changed;
+
+    case MESH_ONOFF_REPORT_POLICY_START_END:
+        return target_changed || (remaining_time == 0);
+
+    case MESH_ONOFF_REPORT_POLICY_ADAPTIVE:
+        if (!state_changed && (remaining_time != 0) && (mesh_onoff_report_skip[element_idx] != 0))
+        {
+            mesh_onoff_report_skip[element_idx]--;
+            return WICED_FALSE;
+        }
+        // Notifications are received every TRANSITION_INTERVAL, spread the reports over the remaining time
+        num_intervals = remaining_time / (TRANSITION_INTERVAL * MESH_ONOFF_ADAPTIVE_REPORTS);
+        mesh_onoff_report_skip[element_idx] = (uint8_t)((num_intervals > 0xff) ? 0xff : num_intervals);
+        return WICED_TRUE;
+
+    default:
+        return WICED_TRUE;
+    }
+}
+
+#ifdef HCI_CONTROL
+/*
+ * Set status report policy of num_elements elements starting from element_idx
+ */
+void mesh_onoff_server_set_report_policy(uint8_t element_idx, uint8_t num_elements, uint8_t policy)
+{
+    uint16_t idx;
+
+    WICED_BT_TRACE("onoff report policy:%d element:%d num:%d\n", policy, element_idx, num_elements);
+
+    for (idx = element_idx; (idx < NUM_ONOFF_SERVERS) && (idx < element_idx + num_elements); idx++)
+    {
+        mesh_onoff_report_policy[idx / 4] &= (uint8_t)~(0x03 << ((idx % 4) * 2));
+        mesh_onoff_report_policy[idx / 4] |= (uint8_t)((policy & 0x03) << ((idx % 4) * 2));
+        mesh_onoff_report_skip[idx] = 0;
+    }
+}
+#endif
+
+/*
+ * Convert time in milliseconds to the Generic Transition Time format (2 bits resolution, 6 bits number of steps).
+ * Number of steps is rounded up so that a transition in progress never shows 0 remaining time.
+ */
+uint8_t mesh_onoff_transition_time_encode(uint32_t time_ms)
+{
+    if (time_ms <= 0x3e * 100)
+        return (uint8_t)((time_ms + 99) / 100);
+    if (time_ms <= 0x3e * 1000)
+        return (uint8_t)(0x40 | ((time_ms + 999) / 1000));
+    if (time_ms <= 0x3e * 10000)
+        return (uint8_t)(0x80 | ((time_ms + 9999) / 10000));
+    if (time_ms <= 0x3e * 600000)
+        return (uint8_t)(0xc0 | ((time_ms + 599999) / 600000));
+    return 0xff;
 }
 
+#ifdef HCI_CONTROL
+/*
+ * Convert Generic Transition Time to milliseconds. Statuses sent later from the app_state (queued and batched events)
+ * report the remaining time rounded up to the transition time steps, statuses sent immediately report the exact time.
+ */
+uint32_t mesh_onoff_transition_time_decode(uint8_t transition_time)
+{
+    static const uint32_t step_ms[4] = { 100, 1000, 10000, 600000 };
+
+    return (transition_time & 0x3f) * step_ms[transition_time >> 6];
+}
+#endif
+
+#if defined(HCI_CONTROL) || defined(ONOFF_SCENES_SUPPORTED) || defined(ONOFF_WRITE_BEHIND_SUPPORTED)
 /*
  * This function shall be called when On/Off state has been changed locally
  */
@@ -474,24 +1370,611 @@ void mesh_onoff_server_send_state_change(uint8_t element_idx, uint8_t onoff)
 {
     wiced_bt_mesh_model_onoff_changed(element_idx, onoff);
 }
+#endif
+
+#if defined(HCI_CONTROL) || defined(ONOFF_SCENES_SUPPORTED)
+/*
+ * This function shall be called when On/Off state of several elements has been changed locally.
+ * Bit i of the masks refers to the element (element_idx + i). Returns number of elements changed.
+ */
+uint8_t mesh_onoff_server_send_state_change_multi(uint8_t element_idx, uint8_t *p_select, uint8_t *p_onoff, uint8_t mask_len)
+{
+    uint8_t  num_changed = 0;
+    uint8_t  i, bit;
+    uint16_t idx;
+
+    for (i = 0; i < mask_len; i++)
+    {
+        // skip the whole byte if none of its elements is selected
+        if (p_select[i] == 0)
+            continue;
+
+        for (bit = 0; bit < 8; bit++)
+        {
+            if ((p_select[i] & (1 << bit)) == 0)
+                continue;
+
+            idx = element_idx + i * 8 + bit;
+            if (idx >= NUM_ONOFF_SERVERS)
+                return num_changed;
+
+            mesh_onoff_server_send_state_change((uint8_t)idx, (p_onoff[i] >> bit) & 1);
+            num_changed++;
+        }
+    }
+    return num_changed;
+}
+#endif
 
 #ifdef HCI_CONTROL
+#ifndef ONOFF_STATUS_BATCH_SUPPORTED
 /*
- * Send OnOff Status event over transport
+ * Send OnOff Status event over transport. If the transport is out of buffers the element is queued and
+ * its latest status is sent later, with the remaining time rounded up to the transition time steps.
  */
 void mesh_onoff_hci_event_send_status(uint8_t element_idx, wiced_bt_mesh_onoff_status_data_t *p_data)
+{
+    // Keep the order of the events if some elements are already waiting for a buffer
+    if ((mesh_onoff_status_queue_count == 0) &&
+        mesh_onoff_hci_event_try_send_status(element_idx, p_data->present_onoff, p_data->target_onoff, p_data->remaining_time))
+        return;
+
+    mesh_onoff_status_queue_put(element_idx);
+}
+
+/*
+ * Allocate HCI event buffer and send OnOff Status event over transport. Returns WICED_FALSE if no buffer is available.
+ */
+wiced_bool_t mesh_onoff_hci_event_try_send_status(uint8_t element_idx, uint8_t present_onoff, uint8_t target_onoff, uint32_t remaining_time)
 {
     wiced_bt_mesh_hci_event_t *p_hci_event = wiced_bt_mesh_alloc_hci_event(element_idx);
     if (p_hci_event)
     {
         uint8_t *p = p_hci_event->data;
 
-        UINT8_TO_STREAM(p, p_data->present_onoff);
-        UINT8_TO_STREAM(p, p_data->target_onoff);
-        UINT32_TO_STREAM(p, p_data->remaining_time);
+        UINT8_TO_STREAM(p, present_onoff);
+        UINT8_TO_STREAM(p, target_onoff);
+        UINT32_TO_STREAM(p, remaining_time);
 
         mesh_transport_send_data(HCI_CONTROL_MESH_EVENT_ONOFF_STATUS, (uint8_t *)p_hci_event, (uint16_t)(p - (uint8_t *)p_hci_event));
+        return WICED_TRUE;
     }
+    MESH_ONOFF_STATS_INC(hci_alloc_fail);
+    return WICED_FALSE;
+}
+
+/*
+ * Queue the element to send its status when the transport has free buffers
+ */
+void mesh_onoff_status_queue_put(uint8_t element_idx)
+{
+    if (MESH_ONOFF_BIT_GET(mesh_onoff_status_queued, element_idx))
+    {
+        // newer status replaces the queued one, it is taken from the app_state when sent
+        MESH_ONOFF_STATS_INC(status_overwritten);
+        return;
+    }
+    if (mesh_onoff_status_queue_count >= MESH_ONOFF_STATUS_QUEUE_SIZE)
+    {
+        MESH_ONOFF_STATS_INC(status_dropped);
+        return;
+    }
+    mesh_onoff_status_queue[(mesh_onoff_status_queue_head + mesh_onoff_status_queue_count) % MESH_ONOFF_STATUS_QUEUE_SIZE] = element_idx;
+    mesh_onoff_status_queue_count++;
+    MESH_ONOFF_BIT_SET(mesh_onoff_status_queued, element_idx);
+    MESH_ONOFF_STATS_INC(status_queued);
+
+    if (!wiced_is_timer_in_use(&mesh_onoff_status_retry_timer))
+        wiced_start_timer(&mesh_onoff_status_retry_timer, MESH_ONOFF_STATUS_RETRY_DELAY);
 }
 
+/*
+ * Send status of the queued elements until the transport runs out of buffers again
+ */
+void mesh_onoff_status_queue_send(void)
+{
+    uint8_t element_idx;
+
+    while (mesh_onoff_status_queue_count != 0)
+    {
+        element_idx = mesh_onoff_status_queue[mesh_onoff_status_queue_head];
+        if (!mesh_onoff_hci_event_try_send_status(element_idx, MESH_ONOFF_BIT_GET(app_state.present_state, element_idx),
+                MESH_ONOFF_BIT_GET(app_state.target_state, element_idx), mesh_onoff_transition_time_decode(app_state.remaining_time[element_idx])))
+        {
+            wiced_start_timer(&mesh_onoff_status_retry_timer, MESH_ONOFF_STATUS_RETRY_DELAY);
+            return;
+        }
+        MESH_ONOFF_BIT_CLEAR(mesh_onoff_status_queued, element_idx);
+        mesh_onoff_status_queue_head = (mesh_onoff_status_queue_head + 1) % MESH_ONOFF_STATUS_QUEUE_SIZE;
+        mesh_onoff_status_queue_count--;
+    }
+}
+
+/*
+ * Retry to send status of the queued elements
+ */
+void mesh_onoff_status_retry_timer_cb(TIMER_PARAM_TYPE arg)
+{
+    mesh_onoff_status_queue_send();
+}
+#endif
+
+/*
+ * Send acknowledgement of the HCI_CONTROL_MESH_COMMAND_ONOFF_SET_MULTI over transport
+ */
+void mesh_onoff_hci_event_send_set_multi_status(uint8_t element_idx, uint8_t num_changed)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event = wiced_bt_mesh_alloc_hci_event(element_idx);
+    if (p_hci_event)
+    {
+        uint8_t *p = p_hci_event->data;
+
+        UINT8_TO_STREAM(p, num_changed);
+
+        mesh_transport_send_data(HCI_CONTROL_MESH_EVENT_ONOFF_SET_MULTI_STATUS, (uint8_t *)p_hci_event, (uint16_t)(p - (uint8_t *)p_hci_event));
+    }
+    else
+    {
+        MESH_ONOFF_STATS_INC(hci_alloc_fail);
+    }
+}
+
+#ifdef ONOFF_SCENES_SUPPORTED
+/*
+ * Send result of a scene command over transport
+ */
+void mesh_onoff_hci_event_send_scene_status(uint8_t element_idx, uint8_t scene_idx, wiced_bool_t success, uint8_t num_changed)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event = wiced_bt_mesh_alloc_hci_event(element_idx);
+    if (p_hci_event)
+    {
+        uint8_t *p = p_hci_event->data;
+
+        UINT8_TO_STREAM(p, scene_idx);
+        UINT8_TO_STREAM(p, success ? 0 : 1);
+        UINT8_TO_STREAM(p, num_changed);
+
+        mesh_transport_send_data(HCI_CONTROL_MESH_EVENT_ONOFF_SCENE_STATUS, (uint8_t *)p_hci_event, (uint16_t)(p - (uint8_t *)p_hci_event));
+    }
+    else
+    {
+        MESH_ONOFF_STATS_INC(hci_alloc_fail);
+    }
+}
+#endif
+
+#ifdef ONOFF_STATS_SUPPORTED
+/*
+ * Send counters and latency histograms over transport
+ */
+void mesh_onoff_hci_event_send_stats(uint8_t element_idx)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event = wiced_bt_mesh_alloc_hci_event(element_idx);
+    uint32_t *p_counter = (uint32_t *)&mesh_onoff_stats;
+    uint16_t i;
+
+    if (p_hci_event)
+    {
+        uint8_t *p = p_hci_event->data;
+
+        for (i = 0; i < sizeof(mesh_onoff_stats) / sizeof(uint32_t); i++)
+            UINT32_TO_STREAM(p, p_counter[i]);
+        for (i = 0; i < MESH_ONOFF_BOOT_PHASES; i++)
+        {
+            UINT32_TO_STREAM(p, (uint32_t)mesh_onoff_boot_time[i]);
+            UINT32_TO_STREAM(p, (uint32_t)(mesh_onoff_boot_time[i] >> 32));
+        }
+
+        mesh_transport_send_data(HCI_CONTROL_MESH_EVENT_ONOFF_STATS, (uint8_t *)p_hci_event, (uint16_t)(p - (uint8_t *)p_hci_event));
+    }
+    else
+    {
+        MESH_ONOFF_STATS_INC(hci_alloc_fail);
+    }
+}
+
+/*
+ * Add time elapsed since start_time to the log2 histogram
+ */
+void mesh_onoff_stats_add_latency(uint32_t *p_histogram, uint64_t start_time)
+{
+    uint32_t latency = (uint32_t)(clock_SystemTimeMicroseconds64() - start_time);
+    uint8_t  bucket = 0;
+
+    while (((latency >>= 1) != 0) && (bucket < MESH_ONOFF_STATS_BUCKETS - 1))
+        bucket++;
+
+    p_histogram[bucket]++;
+}
+#endif
+
+#endif
+
+#ifdef ONOFF_STATUS_BATCH_SUPPORTED
+/*
+ * Mark the status of the element to be sent to the host with the next batch
+ */
+void mesh_onoff_batch_add_status(uint8_t element_idx)
+{
+    if (!MESH_ONOFF_BIT_GET(mesh_onoff_batch_pending, element_idx))
+    {
+        MESH_ONOFF_BIT_SET(mesh_onoff_batch_pending, element_idx);
+        mesh_onoff_batch_num_pending++;
+    }
+    else
+    {
+        // newer status replaces the pending one, it is taken from the app_state when sent
+        MESH_ONOFF_STATS_INC(status_overwritten);
+    }
+
+    if (mesh_onoff_batch_num_pending >= ONOFF_STATUS_BATCH_MAX_ENTRIES)
+        mesh_onoff_batch_flush();
+    else if (!wiced_is_timer_in_use(&mesh_onoff_batch_timer))
+        wiced_start_timer(&mesh_onoff_batch_timer, ONOFF_STATUS_BATCH_WINDOW);
+}
+
+/*
+ * Send status of all pending elements over transport, ONOFF_STATUS_BATCH_MAX_ENTRIES elements per event.
+ * Elements stay pending if the transport is out of buffers, and sending is retried later.
+ */
+void mesh_onoff_batch_flush(void)
+{
+    wiced_bt_mesh_hci_event_t *p_hci_event;
+    uint8_t *p, *p_num;
+    uint8_t element_idx = 0;
+
+    if (wiced_is_timer_in_use(&mesh_onoff_batch_timer))
+        wiced_stop_timer(&mesh_onoff_batch_timer);
+
+    while (mesh_onoff_batch_num_pending != 0)
+    {
+        p_hci_event = wiced_bt_mesh_alloc_hci_event(MESH_ONOFF_SERVER_ELEMENT_INDEX);
+        if (p_hci_event == NULL)
+        {
+            MESH_ONOFF_STATS_INC(hci_alloc_fail);
+            MESH_ONOFF_STATS_INC(status_queued);
+            wiced_start_timer(&mesh_onoff_batch_timer, MESH_ONOFF_STATUS_RETRY_DELAY);
+            return;
+        }
+        p = p_hci_event->data;
+        p_num = p++;
+        *p_num = 0;
+
+        for (; (element_idx < NUM_ONOFF_SERVERS) && (*p_num < ONOFF_STATUS_BATCH_MAX_ENTRIES); element_idx++)
+        {
+            if (!MESH_ONOFF_BIT_GET(mesh_onoff_batch_pending, element_idx))
+                continue;
+
+            UINT8_TO_STREAM(p, element_idx);
+            UINT8_TO_STREAM(p, MESH_ONOFF_BIT_GET(app_state.present_state, element_idx));
+            UINT8_TO_STREAM(p, MESH_ONOFF_BIT_GET(app_state.target_state, element_idx));
+            UINT32_TO_STREAM(p, mesh_onoff_transition_time_decode(app_state.remaining_time[element_idx]));
+            (*p_num)++;
+
+            MESH_ONOFF_BIT_CLEAR(mesh_onoff_batch_pending, element_idx);
+            mesh_onoff_batch_num_pending--;
+        }
+        mesh_transport_send_data(HCI_CONTROL_MESH_EVENT_ONOFF_STATUS_BATCH, (uint8_t *)p_hci_event, (uint16_t)(p - (uint8_t *)p_hci_event));
+    }
+}
+
+/*
+ * Batch window expired, send collected status to the host
+ */
+void mesh_onoff_batch_timer_cb(TIMER_PARAM_TYPE arg)
+{
+    mesh_onoff_batch_flush();
+}
+#endif
+
+#ifdef ONOFF_VENDOR_STATUS_SUPPORTED
+/*
+ * Add element to the next vendor model multi element status
+ */
+void mesh_onoff_vendor_status_add(uint8_t element_idx)
+{
+    MESH_ONOFF_STATS_INC(vendor_status_changes);
+    MESH_ONOFF_BIT_SET(mesh_onoff_vendor_status_pending, element_idx);
+    if (!wiced_is_timer_in_use(&mesh_onoff_vendor_status_timer))
+        wiced_start_timer(&mesh_onoff_vendor_status_timer, ONOFF_VENDOR_STATUS_WINDOW);
+}
+
+/*
+ * Publish state of all pending elements in one vendor model message. Masks are cut after the last byte with a pending element.
+ * If the mesh core fails to send the message, the elements stay pending and are published after the next window.
+ */
+void mesh_onoff_vendor_status_publish(void)
+{
+    wiced_bt_mesh_event_t *p_event;
+    uint8_t buffer[3 * MESH_ONOFF_BITSET_LEN];
+    uint8_t mask_len = MESH_ONOFF_BITSET_LEN;
+    uint8_t i;
+
+    while ((mask_len > 0) && (mesh_onoff_vendor_status_pending[mask_len - 1] == 0))
+        mask_len--;
+    if (mask_len == 0)
+        return;
+
+    for (i = 0; i < mask_len; i++)
+    {
+        buffer[i]                = mesh_onoff_vendor_status_pending[i];
+        buffer[mask_len + i]     = app_state.present_state[i] & mesh_onoff_vendor_status_pending[i];
+        buffer[2 * mask_len + i] = app_state.target_state[i] & mesh_onoff_vendor_status_pending[i];
+    }
+    memset(mesh_onoff_vendor_status_pending, 0, sizeof(mesh_onoff_vendor_status_pending));
+
+    // Destination and app key are taken from the model publication
+    p_event = wiced_bt_mesh_create_event(MESH_ONOFF_SERVER_ELEMENT_INDEX, MESH_ONOFF_VENDOR_COMPANY_ID, MESH_ONOFF_VENDOR_MODEL_ID, 0, 0);
+    if (p_event == NULL)
+    {
+        MESH_ONOFF_STATS_INC(vendor_status_no_publication);
+        return;
+    }
+    p_event->opcode = MESH_ONOFF_VENDOR_OPCODE_MULTI_STATUS;
+    if (wiced_bt_mesh_core_send(p_event, buffer, (uint16_t)(3 * mask_len), NULL) != WICED_SUCCESS)
+    {
+        MESH_ONOFF_STATS_INC(vendor_status_send_fail);
+        for (i = 0; i < mask_len; i++)
+            mesh_onoff_vendor_status_pending[i] |= buffer[i];
+        if (!wiced_is_timer_in_use(&mesh_onoff_vendor_status_timer))
+            wiced_start_timer(&mesh_onoff_vendor_status_timer, ONOFF_VENDOR_STATUS_WINDOW);
+        return;
+    }
+    MESH_ONOFF_STATS_INC(vendor_status_published);
+}
+
+/*
+ * Vendor status window expired, publish collected state changes
+ */
+void mesh_onoff_vendor_status_timer_cb(TIMER_PARAM_TYPE arg)
+{
+    mesh_onoff_vendor_status_publish();
+}
+#endif
+
+#ifdef ONOFF_DEFERRED_TRACE_SUPPORTED
+/*
+ * Save trace record to be formatted later. If the ring buffer is full the record is lost.
+ * Once the ring buffer is half full the drain timer is restarted with a short delay so that
+ * a burst of records is formatted before it overflows the ring buffer.
+ */
+void mesh_onoff_trace_put(uint16_t id, uint16_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    uint16_t head = mesh_onoff_trace_head;
+    mesh_onoff_trace_record_t *p_rec;
+
+    if ((uint16_t)(head - mesh_onoff_trace_tail) >= MESH_ONOFF_TRACE_RING_SIZE)
+    {
+        mesh_onoff_trace_lost++;
+        return;
+    }
+    p_rec = &mesh_onoff_trace_ring[head & (MESH_ONOFF_TRACE_RING_SIZE - 1)];
+    p_rec->id   = id;
+    p_rec->arg0 = arg0;
+    p_rec->arg1 = arg1;
+    p_rec->arg2 = arg2;
+    mesh_onoff_trace_head = ++head;
+
+    if ((uint16_t)(head - mesh_onoff_trace_tail) == MESH_ONOFF_TRACE_RING_SIZE / 2)
+    {
+        wiced_stop_timer(&mesh_onoff_trace_timer);
+        wiced_start_timer(&mesh_onoff_trace_timer, MESH_ONOFF_TRACE_DRAIN_EARLY_DELAY);
+    }
+    else if (!wiced_is_timer_in_use(&mesh_onoff_trace_timer))
+    {
+        wiced_start_timer(&mesh_onoff_trace_timer, MESH_ONOFF_TRACE_DRAIN_DELAY);
+    }
+}
+
+/*
+ * Format and output all saved trace records
+ */
+void mesh_onoff_trace_drain(void)
+{
+    mesh_onoff_trace_record_t *p_rec;
+
+    while (mesh_onoff_trace_tail != mesh_onoff_trace_head)
+    {
+        p_rec = &mesh_onoff_trace_ring[mesh_onoff_trace_tail & (MESH_ONOFF_TRACE_RING_SIZE - 1)];
+        if (p_rec->id < sizeof(mesh_onoff_trace_fmt) / sizeof(mesh_onoff_trace_fmt[0]))
+            WICED_BT_TRACE(mesh_onoff_trace_fmt[p_rec->id], p_rec->arg0, p_rec->arg1, p_rec->arg2);
+        mesh_onoff_trace_tail++;
+    }
+    if (mesh_onoff_trace_lost)
+    {
+        WICED_BT_TRACE("onoff trace lost:%d\n", mesh_onoff_trace_lost);
+        mesh_onoff_trace_lost = 0;
+    }
+}
+
+/*
+ * Drain delay expired, output saved trace records
+ */
+void mesh_onoff_trace_timer_cb(TIMER_PARAM_TYPE arg)
+{
+    mesh_onoff_trace_drain();
+}
+#endif
+
+#ifdef ONOFF_SCENES_SUPPORTED
+/*
+ * Read stored scenes from NVRAM
+ */
+void mesh_onoff_scenes_restore(void)
+{
+    wiced_result_t result;
+    uint8_t        scene_idx;
+
+    mesh_onoff_scenes_valid = 0;
+    for (scene_idx = 0; scene_idx < MESH_ONOFF_SCENES_MAX; scene_idx++)
+    {
+        if ((wiced_hal_read_nvram(MESH_ONOFF_NVRAM_ID_SCENE_START + scene_idx, sizeof(mesh_onoff_scene_t), (uint8_t *)&mesh_onoff_scenes[scene_idx], &result) == sizeof(mesh_onoff_scene_t)) &&
+            (result == WICED_SUCCESS))
+            mesh_onoff_scenes_valid |= (1 << scene_idx);
+    }
+}
+
+/*
+ * Store scene. If p_select is NULL all elements are selected, if p_onoff is NULL the current target state is stored.
+ */
+wiced_bool_t mesh_onoff_scene_store(uint8_t scene_idx, uint8_t *p_select, uint8_t *p_onoff, uint8_t mask_len)
+{
+    mesh_onoff_scene_t scene;
+    wiced_result_t     result;
+    uint8_t            i;
+
+    if (scene_idx >= MESH_ONOFF_SCENES_MAX)
+        return WICED_FALSE;
+
+    for (i = 0; i < MESH_ONOFF_BITSET_LEN; i++)
+    {
+        scene.select[i] = (p_select == NULL) ? 0xff : (i < mask_len) ? p_select[i] : 0;
+        scene.onoff[i]  = ((p_onoff == NULL) ? app_state.target_state[i] : (i < mask_len) ? p_onoff[i] : 0) & scene.select[i];
+    }
+    // The scene in RAM is replaced only if it has been saved, so that it matches the NVRAM after reboot
+    if ((wiced_hal_write_nvram(MESH_ONOFF_NVRAM_ID_SCENE_START + scene_idx, sizeof(scene), (uint8_t *)&scene, &result) != sizeof(scene)) ||
+        (result != WICED_SUCCESS))
+    {
+        WICED_BT_TRACE("onoff scene store:%d failed result:%d\n", scene_idx, result);
+        return WICED_FALSE;
+    }
+    mesh_onoff_scenes[scene_idx] = scene;
+    mesh_onoff_scenes_valid |= (1 << scene_idx);
+    return WICED_TRUE;
+}
+
+/*
+ * Set state of all elements of the scene in one pass
+ */
+wiced_bool_t mesh_onoff_scene_recall(uint8_t scene_idx, uint8_t *p_num_changed)
+{
+    if ((scene_idx >= MESH_ONOFF_SCENES_MAX) || ((mesh_onoff_scenes_valid & (1 << scene_idx)) == 0))
+        return WICED_FALSE;
+
+    *p_num_changed = mesh_onoff_server_send_state_change_multi(0, mesh_onoff_scenes[scene_idx].select, mesh_onoff_scenes[scene_idx].onoff, MESH_ONOFF_BITSET_LEN);
+    return WICED_TRUE;
+}
+
+/*
+ * Delete scene from RAM and NVRAM
+ */
+wiced_bool_t mesh_onoff_scene_delete(uint8_t scene_idx)
+{
+    wiced_result_t result;
+
+    if ((scene_idx >= MESH_ONOFF_SCENES_MAX) || ((mesh_onoff_scenes_valid & (1 << scene_idx)) == 0))
+        return WICED_FALSE;
+
+    wiced_hal_delete_nvram(MESH_ONOFF_NVRAM_ID_SCENE_START + scene_idx, &result);
+    if (result != WICED_SUCCESS)
+        return WICED_FALSE;
+
+    mesh_onoff_scenes_valid &= ~(1 << scene_idx);
+    return WICED_TRUE;
+}
+
+/*
+ * Delete all scenes on factory reset, including scenes not loaded because they could not be read
+ */
+void mesh_onoff_scenes_factory_reset(void)
+{
+    wiced_result_t result;
+    uint8_t        scene_idx;
+
+    for (scene_idx = 0; scene_idx < MESH_ONOFF_SCENES_MAX; scene_idx++)
+        wiced_hal_delete_nvram(MESH_ONOFF_NVRAM_ID_SCENE_START + scene_idx, &result);
+
+    mesh_onoff_scenes_valid = 0;
+}
+#endif
+
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+/*
+ * Find the newest record of the log and set OnOff state of the elements saved as on
+ */
+void mesh_onoff_log_restore(void)
+{
+    mesh_onoff_log_record_t record;
+    wiced_result_t          result;
+    uint8_t                 slot;
+    uint8_t                 element_idx;
+
+    memset(&mesh_onoff_log, 0, sizeof(mesh_onoff_log));
+    for (slot = 0; slot < MESH_ONOFF_LOG_SLOTS; slot++)
+    {
+        if ((wiced_hal_read_nvram(MESH_ONOFF_NVRAM_ID_LOG_START + slot, sizeof(record), (uint8_t *)&record, &result) == sizeof(record)) &&
+            (result == WICED_SUCCESS) && (record.sequence > mesh_onoff_log.sequence))
+            mesh_onoff_log = record;
+    }
+    WICED_BT_TRACE("onoff log restore sequence:%d\n", mesh_onoff_log.sequence);
+
+    for (element_idx = 0; element_idx < NUM_ONOFF_SERVERS; element_idx++)
+    {
+        if (MESH_ONOFF_BIT_GET(mesh_onoff_log.target_state, element_idx))
+            mesh_onoff_server_send_state_change(element_idx, 1);
+    }
+}
+
+/*
+ * Write OnOff state to the next slot of the log if it differs from the last record.
+ * Changes which were reverted before the flush do not cause a write.
+ */
+void mesh_onoff_log_flush(void)
+{
+    mesh_onoff_log_record_t record;
+    wiced_result_t          result;
+
+    if (wiced_is_timer_in_use(&mesh_onoff_log_timer))
+        wiced_stop_timer(&mesh_onoff_log_timer);
+
+    if (memcmp(mesh_onoff_log.target_state, app_state.target_state, sizeof(mesh_onoff_log.target_state)) == 0)
+        return;
+
+    record.sequence = mesh_onoff_log.sequence + 1;
+    memcpy(record.target_state, app_state.target_state, sizeof(record.target_state));
+
+    wiced_hal_write_nvram(MESH_ONOFF_NVRAM_ID_LOG_START + (record.sequence % MESH_ONOFF_LOG_SLOTS), sizeof(record), (uint8_t *)&record, &result);
+    MESH_ONOFF_STATS_INC(log_writes);
+    if (result == WICED_SUCCESS)
+        mesh_onoff_log = record;
+    else
+        wiced_start_timer(&mesh_onoff_log_timer, MESH_ONOFF_LOG_FLUSH_DELAY);
+}
+
+/*
+ * Log flush delay expired, write collected changes
+ */
+void mesh_onoff_log_timer_cb(TIMER_PARAM_TYPE arg)
+{
+    mesh_onoff_log_flush();
+}
+
+/*
+ * Delete the log on factory reset
+ */
+void mesh_onoff_log_factory_reset(void)
+{
+    wiced_result_t result;
+    uint8_t        slot;
+
+    for (slot = 0; slot < MESH_ONOFF_LOG_SLOTS; slot++)
+        wiced_hal_delete_nvram(MESH_ONOFF_NVRAM_ID_LOG_START + slot, &result);
+
+    memset(&mesh_onoff_log, 0, sizeof(mesh_onoff_log));
+}
+#endif
+
+#if defined(ONOFF_WRITE_BEHIND_SUPPORTED) || defined(ONOFF_SCENES_SUPPORTED)
+/*
+ * Delete application data saved in NVRAM on factory reset
+ */
+void mesh_app_factory_reset(void)
+{
+#ifdef ONOFF_WRITE_BEHIND_SUPPORTED
+    mesh_onoff_log_factory_reset();
+#endif
+#ifdef ONOFF_SCENES_SUPPORTED
+    mesh_onoff_scenes_factory_reset();
+#endif
+}
 #endif